@@ -0,0 +1,111 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// bitset.cpp -- leaf bit vectors
+
+#include "bitset.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BITS_AVX2
+#endif
+
+#ifdef BITS_AVX2
+
+// checked once, the branches on it are always predicted
+static const bool bits_avx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}();
+
+__attribute__((target("avx2")))
+static void Bits_OrAVX2(std::uint64_t *dst, const std::uint64_t *src, int words) {
+    int i = 0;
+
+    for (; i + 4 <= words; i += 4) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_or_si256(a, b));
+    }
+    for (; i < words; i++)
+        dst[i] |= src[i];
+}
+
+// eight indices a time: gather the 32 bit words holding them and test
+// the bits in one go
+__attribute__((target("avx2")))
+static auto Bits_TestAnyAVX2(const void *bits, const short *indices, int count) -> bool {
+    const auto *words = static_cast<const int *>(bits);
+    const auto one = _mm256_set1_epi32(1);
+    const auto low = _mm256_set1_epi32(31);
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const auto index = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i)));
+        const auto word = _mm256_i32gather_epi32(words, _mm256_srli_epi32(index, 5), 4);
+        const auto mask = _mm256_sllv_epi32(one, _mm256_and_si256(index, low));
+        if (!_mm256_testz_si256(word, mask))
+            return true;
+    }
+
+    const auto *bytes = static_cast<const unsigned char *>(bits);
+    for (; i < count; i++) {
+        if (bytes[indices[i] >> 3] & (1 << (indices[i] & 7)))
+            return true;
+    }
+    return false;
+}
+
+#endif
+
+/*
+==================
+Bits_Or
+==================
+*/
+void Bits_Or(std::uint64_t *dst, const std::uint64_t *src, int words) {
+#ifdef BITS_AVX2
+    if (bits_avx2) {
+        Bits_OrAVX2(dst, src, words);
+        return;
+    }
+#endif
+
+    for (int i = 0; i < words; i++)
+        dst[i] |= src[i];
+}
+
+/*
+==================
+Bits_TestAny
+==================
+*/
+auto Bits_TestAny(const void *bits, const short *indices, int count) -> bool {
+#ifdef BITS_AVX2
+    if (bits_avx2 && count >= 8)
+        return Bits_TestAnyAVX2(bits, indices, count);
+#endif
+
+    const auto *bytes = static_cast<const unsigned char *>(bits);
+    for (int i = 0; i < count; i++) {
+        if (bytes[indices[i] >> 3] & (1 << (indices[i] & 7)))
+            return true;
+    }
+    return false;
+}
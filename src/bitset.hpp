@@ -0,0 +1,58 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+#pragma once
+
+/* bitset.h -- leaf bit vectors, with AVX2 versions picked at runtime */
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+// dst |= src over words 64 bit words
+void Bits_Or(std::uint64_t *dst, const std::uint64_t *src, int words);
+
+// true if any of the count bit numbers in indices is set. bits must be
+// readable in whole 32 bit words up to the highest index.
+auto Bits_TestAny(const void *bits, const short *indices, int count) -> bool;
+
+/*
+==================
+Bits_ForEachSet
+
+Calls f with the number of every set bit below count, skipping clear
+bytes 64 bits at a time
+==================
+*/
+template<typename F>
+void Bits_ForEachSet(const void *bits, int count, F &&f) {
+    const auto *bytes = static_cast<const unsigned char *>(bits);
+
+    for (int base = 0; base < count; base += 64) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, bytes + base / 8, count - base >= 64 ? 8 : (count - base + 7) / 8);
+        if (count - base < 64)
+            word &= (std::uint64_t{1} << (count - base)) - 1;
+
+        while (word) {
+            f(base + std::countr_zero(word));
+            word &= word - 1;
+        }
+    }
+}
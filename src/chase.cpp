@@ -50,7 +50,7 @@ void TraceLine(vec3 start, vec3 end, vec3 &impact) {
     trace_t trace;
 
     memset(&trace, 0, sizeof(trace));
-    SV_RecursiveHullCheck(cl.worldmodel->hulls, 0, 0, 1, start, end, &trace);
+    SV_HullCheck(cl.worldmodel->hulls, 0, 0, 1, start, end, &trace);
 
     impact = trace.endpos;
 }
@@ -415,6 +415,9 @@ void CL_SendMove(usercmd_t *cmd) {
     MSG_WriteByte(&buf, in_impulse);
     in_impulse = 0;
 
+    if (cl.protocol == PROTOCOL_DELTA)
+        MSG_WriteLong(&buf, cl.entityframe);
+
 #ifdef QUAKE2
     //
     // light level
@@ -19,6 +19,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // cl_parse.c  -- parse a message received from the server
 
+#include <algorithm>
 #include <cmath>
 #include "quakedef.hpp"
 
@@ -65,9 +66,134 @@ static constexpr std::array svc_strings =
                 "svc_finale",            // [string] music [string] text
                 "svc_cdtrack",            // [byte] track [byte] looptrack
                 "svc_sellscreen",
-                "svc_cutscene"
+                "svc_cutscene",
+                "svc_entityframe"        // [long] frame [byte] frames back
         };
 
+/*
+==============================================================================
+
+With PROTOCOL_DELTA every entity update is compressed against the state the
+entity had in a recent frame the client acknowledged, rather than against
+its baseline. The client keeps the states it decoded for the last
+UPDATE_BACKUP frames.
+
+==============================================================================
+*/
+
+using clframeentity_t = struct {
+    int num;
+    entity_state_t state;
+};
+
+using clframe_t = struct {
+    int sequence;        // 0 if the frame isn't complete or valid
+    std::vector<clframeentity_t> entities;        // in entity number order
+};
+
+static std::array<clframe_t, UPDATE_BACKUP> cl_frames;
+static clframe_t *cl_parseframe;        // frame the updates being parsed belong to
+static clframe_t *cl_deltaframe;        // frame they are compressed against, NULL for the baselines
+static qboolean cl_skipframe;        // the delta frame is gone, so the updates are read and dropped
+
+/*
+==================
+CL_ClearFrames
+==================
+*/
+static void CL_ClearFrames() {
+    for (auto &frame: cl_frames) {
+        frame.sequence = 0;
+        frame.entities.clear();
+    }
+    cl_parseframe = nullptr;
+    cl_deltaframe = nullptr;
+    cl_skipframe = false;
+}
+
+/*
+==================
+CL_ParseEntityFrame
+
+Starts a frame of entity updates
+==================
+*/
+void CL_ParseEntityFrame() {
+    const auto sequence = MSG_ReadLong();
+    const auto back = MSG_ReadByte();
+
+    if (cl.protocol != PROTOCOL_DELTA || sequence <= 0 || back < 0 || back >= UPDATE_BACKUP)
+        Host_Error("CL_ParseEntityFrame: bad frame %i - %i\n", sequence, back);
+
+    cl_parseframe = &cl_frames[sequence & UPDATE_MASK];
+    cl_parseframe->sequence = sequence;
+    cl_parseframe->entities.clear();
+
+    cl_deltaframe = nullptr;
+    cl_skipframe = false;
+    if (back) {
+        cl_deltaframe = &cl_frames[(sequence - back) & UPDATE_MASK];
+        if (cl_deltaframe->sequence != sequence - back) {
+            // lost track of it, so none of this frame can be decoded. Ask
+            // for one compressed against the baselines.
+            Con_DPrintf("Delta from frame %i, which isn't held\n", sequence - back);
+            cl_parseframe->sequence = 0;
+            cl_parseframe = nullptr;
+            cl_deltaframe = nullptr;
+            cl_skipframe = true;
+            cl.entityframe = 0;
+            return;
+        }
+    }
+
+    cl.entityframe = sequence;
+}
+
+/*
+==================
+CL_DeltaFrom
+
+The state an update of entity num is compressed against
+==================
+*/
+static auto CL_DeltaFrom(int num, const entity_t *ent) -> const entity_state_t * {
+    if (!cl_deltaframe)
+        return &ent->baseline;
+
+    const auto &entities = cl_deltaframe->entities;
+    const auto it = std::lower_bound(entities.begin(), entities.end(), num,
+                                     [](const clframeentity_t &e, int n) { return e.num < n; });
+    if (it == entities.end() || it->num != num)
+        return &ent->baseline;        // wasn't sent in that frame
+    return &it->state;
+}
+
+/*
+==================
+CL_SkipUpdate
+
+Reads past the fields of an update in a frame that can't be decoded
+==================
+*/
+static void CL_SkipUpdate(int bits) {
+    for (const auto field: {U_MODEL, U_FRAME, U_COLORMAP, U_SKIN, U_EFFECTS})
+        if (bits & field)
+            MSG_ReadByte();
+
+    if (bits & U_ORIGIN1)
+        MSG_ReadCoord();
+    if (bits & U_ANGLE1)
+        MSG_ReadAngle();
+    if (bits & U_ORIGIN2)
+        MSG_ReadCoord();
+    if (bits & U_ANGLE2)
+        MSG_ReadAngle();
+    if (bits & U_ORIGIN3)
+        MSG_ReadCoord();
+    if (bits & U_ANGLE3)
+        MSG_ReadAngle();
+}
+
 //=============================================================================
 
 /*
@@ -210,10 +336,12 @@ void CL_ParseServerInfo() {
 
 // parse protocol version number
     i = MSG_ReadLong();
-    if (i != PROTOCOL_VERSION) {
+    if (i != PROTOCOL_VERSION && i != PROTOCOL_DELTA) {
         Con_Printf("Server returned version %i, not %i", i, PROTOCOL_VERSION);
         return;
     }
+    cl.protocol = i;
+    CL_ClearFrames();
 
 // parse maxclients
     cl.maxclients = MSG_ReadByte();
@@ -321,6 +449,7 @@ void CL_ParseUpdate(int bits) {
     entity_t *ent = nullptr;
     int num = 0;
     int skin = 0;
+    int colormap = 0;
 
     if (cls.signon == SIGNONS - 1) {    // first update is the final signon stage
         cls.signon = SIGNONS;
@@ -339,6 +468,19 @@ void CL_ParseUpdate(int bits) {
 
     ent = CL_EntityNum(num);
 
+    if (cl_skipframe) {
+        // keep it where it was until a frame that can be decoded comes
+        CL_SkipUpdate(bits);
+        if (ent->msgtime == cl.mtime[1]) {
+            ent->msgtime = cl.mtime[0];
+            ent->msg_origins[1] = ent->msg_origins[0];
+            ent->msg_angles[1] = ent->msg_angles[0];
+        }
+        return;
+    }
+
+    const auto *from = CL_DeltaFrom(num, ent);
+
     for (i = 0; i < 16; i++)
         if (bits & (1 << i))
             bitcounts[i]++;
@@ -355,7 +497,7 @@ void CL_ParseUpdate(int bits) {
         if (modnum >= MAX_MODELS)
             Host_Error("CL_ParseModel: bad modnum");
     } else
-        modnum = ent->baseline.modelindex;
+        modnum = from->modelindex;
 
     model = cl.model_precache[modnum];
     if (model != ent->model) {
@@ -378,25 +520,25 @@ void CL_ParseUpdate(int bits) {
     if (bits & U_FRAME)
         ent->frame = MSG_ReadByte();
     else
-        ent->frame = ent->baseline.frame;
+        ent->frame = from->frame;
 
     if (bits & U_COLORMAP)
-        i = MSG_ReadByte();
+        colormap = MSG_ReadByte();
     else
-        i = ent->baseline.colormap;
-    if (!i)
+        colormap = from->colormap;
+    if (!colormap)
         ent->colormap = vid.colormap;
     else {
-        if (i > cl.maxclients)
+        if (colormap > cl.maxclients)
             Sys_Error("i >= cl.maxclients");
-        ent->colormap = cl.scores[i - 1].translations;
+        ent->colormap = cl.scores[colormap - 1].translations;
     }
 
 #ifdef GLQUAKE
     if (bits & U_SKIN)
         skin = MSG_ReadByte();
     else
-        skin = ent->baseline.skin;
+        skin = from->skin;
     if (skin != ent->skinnum) {
         ent->skinnum = skin;
         if (num > 0 && num <= cl.maxclients)
@@ -408,13 +550,13 @@ void CL_ParseUpdate(int bits) {
     if (bits & U_SKIN)
         ent->skinnum = MSG_ReadByte();
     else
-        ent->skinnum = ent->baseline.skin;
+        ent->skinnum = from->skin;
 #endif
 
     if (bits & U_EFFECTS)
         ent->effects = MSG_ReadByte();
     else
-        ent->effects = ent->baseline.effects;
+        ent->effects = from->effects;
 
 // shift the known values for interpolation
     ent->msg_origins[1] = ent->msg_origins[0];
@@ -423,29 +565,29 @@ void CL_ParseUpdate(int bits) {
     if (bits & U_ORIGIN1)
         ent->msg_origins[0][0] = MSG_ReadCoord();
     else
-        ent->msg_origins[0][0] = ent->baseline.origin[0];
+        ent->msg_origins[0][0] = from->origin[0];
     if (bits & U_ANGLE1)
         ent->msg_angles[0][0] = MSG_ReadAngle();
     else
-        ent->msg_angles[0][0] = ent->baseline.angles[0];
+        ent->msg_angles[0][0] = from->angles[0];
 
     if (bits & U_ORIGIN2)
         ent->msg_origins[0][1] = MSG_ReadCoord();
     else
-        ent->msg_origins[0][1] = ent->baseline.origin[1];
+        ent->msg_origins[0][1] = from->origin[1];
     if (bits & U_ANGLE2)
         ent->msg_angles[0][1] = MSG_ReadAngle();
     else
-        ent->msg_angles[0][1] = ent->baseline.angles[1];
+        ent->msg_angles[0][1] = from->angles[1];
 
     if (bits & U_ORIGIN3)
         ent->msg_origins[0][2] = MSG_ReadCoord();
     else
-        ent->msg_origins[0][2] = ent->baseline.origin[2];
+        ent->msg_origins[0][2] = from->origin[2];
     if (bits & U_ANGLE3)
         ent->msg_angles[0][2] = MSG_ReadAngle();
     else
-        ent->msg_angles[0][2] = ent->baseline.angles[2];
+        ent->msg_angles[0][2] = from->angles[2];
 
     if (bits & U_NOLERP)
         ent->forcelink = true;
@@ -457,6 +599,19 @@ void CL_ParseUpdate(int bits) {
         ent->angles = ent->msg_angles[0];
         ent->forcelink = true;
     }
+
+// remember what it was for the updates compressed against this frame
+    if (cl_parseframe && (cl_parseframe->entities.empty() || cl_parseframe->entities.back().num < num)) {
+        entity_state_t state;
+        state.origin = ent->msg_origins[0];
+        state.angles = ent->msg_angles[0];
+        state.modelindex = modnum;
+        state.frame = ent->frame;
+        state.colormap = colormap;
+        state.skin = ent->skinnum;
+        state.effects = ent->effects;
+        cl_parseframe->entities.push_back({num, state});
+    }
 }
 
 /*
@@ -688,6 +843,9 @@ void CL_ParseServerMessage() {
 // parse the message
 //
     MSG_BeginReading();
+    cl_parseframe = nullptr;
+    cl_deltaframe = nullptr;
+    cl_skipframe = false;
 
     while (true) {
         if (msg_badread)
@@ -733,7 +891,7 @@ void CL_ParseServerMessage() {
 
             case svc_version:
                 i = MSG_ReadLong();
-                if (i != PROTOCOL_VERSION)
+                if (i != PROTOCOL_VERSION && i != PROTOCOL_DELTA)
                     Host_Error("CL_ParseServerMessage: Server is protocol %i instead of %i\n", i, PROTOCOL_VERSION);
                 break;
 
@@ -906,6 +1064,10 @@ void CL_ParseServerMessage() {
             case svc_sellscreen:
                 Cmd_ExecuteString("help", src_command);
                 break;
+
+            case svc_entityframe:
+                CL_ParseEntityFrame();
+                break;
         }
     }
 }
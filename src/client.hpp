@@ -211,6 +211,8 @@ typedef struct {
     int viewentity;        // cl_entitites[cl.viewentity] = player
     int maxclients;
     int gametype;
+    int protocol;        // PROTOCOL_VERSION or PROTOCOL_DELTA
+    int entityframe;    // last complete svc_entityframe, acknowledged in every move
 
 // refresh related state
     struct model_s *worldmodel;    // cl_entitites[0].model
@@ -360,7 +360,11 @@ auto Q_atof(std::string_view str) -> float {
 
 ============================================================================
 */
+#ifdef SDL
 #include <SDL.h>
+#else
+#include <bit>
+#endif
 
 qboolean bigendien;
 
@@ -641,6 +645,14 @@ auto MSG_ReadAngle() -> float {
     return static_cast<float>(MSG_ReadChar()) * (360.0f / 256.f);
 }
 
+auto MSG_RoundCoord(float f) -> float {
+    return static_cast<float>(static_cast<short>(f * 8)) * (1.0f / 8.f);
+}
+
+auto MSG_RoundAngle(float f) -> float {
+    return static_cast<float>(static_cast<signed char>(((int) f * 256 / 360) & 255)) * (360.0f / 256.f);
+}
+
 
 
 //===========================================================================
@@ -1030,7 +1042,7 @@ void COM_Init() {
     // This is necessary because egcs 1.1.1 mis-compiles swaptest with -O2
     if constexpr (SDL_BYTEORDER == SDL_LIL_ENDIAN)
 #else
-        if constexpr ( __LITTLE_ENDIAN__ )
+    if constexpr (std::endian::native == std::endian::little)
 #endif
     {
         bigendien = false;
@@ -1078,6 +1090,7 @@ QUAKE FILESYSTEM
 */
 
 int com_filesize;
+int com_filetime;
 
 
 //
@@ -1167,7 +1180,7 @@ void COM_WriteFile(char *filename, void *data, int len) {
 ============
 COM_CreatePath
 
-Only used for CopyFile
+Creates the directories leading up to a file in the cache
 ============
 */
 void COM_CreatePath(char *path) {
@@ -1218,7 +1231,7 @@ void COM_CopyFile(const char *netpath, char *cachepath) {
 COM_FindFile
 
 Finds the file in the search path.
-Sets com_filesize and one of handle or file
+Sets com_filesize, com_filetime and one of handle or file
 ===========
 */
 auto COM_FindFile(std::string_view filename, int *handle, FILE **file) -> int {
@@ -1258,6 +1271,7 @@ auto COM_FindFile(std::string_view filename, int *handle, FILE **file) -> int {
                             fseek(*file, pak->files[i].filepos, SEEK_SET);
                     }
                     com_filesize = pak->files[i].filelen;
+                    com_filetime = Sys_FileTime(pak->filename);
                     return com_filesize;
                 }
         } else {
@@ -1296,6 +1310,7 @@ auto COM_FindFile(std::string_view filename, int *handle, FILE **file) -> int {
 
             sysPrintf("FindFile: %s\n", netpath);
             com_filesize = Sys_FileOpenRead(netpath.c_str(), &i);
+            com_filetime = findtime;
             if (handle)
                 *handle = i;
             else {
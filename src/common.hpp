@@ -148,6 +148,11 @@ float MSG_ReadCoord();
 
 float MSG_ReadAngle();
 
+// what a value reads back as after MSG_WriteCoord / MSG_WriteAngle
+auto MSG_RoundCoord(float f) -> float;
+
+auto MSG_RoundAngle(float f) -> float;
+
 //============================================================================
 
 void Q_memset(void *dest, int fill, int count);
@@ -232,12 +237,15 @@ std::string va(const S &fmt, Args &&... args) {
 //============================================================================
 
 extern int com_filesize;
+extern int com_filetime;    // of the file or pak the last file found came from
 struct cache_user_s;
 
 extern char com_gamedir[MAX_OSPATH];
 
 void COM_WriteFile(char *filename, void *data, int len);
 
+void COM_CreatePath(char *path);
+
 int COM_OpenFile(std::string_view filename, int *handle);
 
 int COM_FOpenFile(std::string_view filename, FILE **file);
@@ -159,9 +159,9 @@ void Host_FindMaxClients() {
     svs.maxclients = 1;
 
     i = COM_CheckParm("-dedicated");
-    if (i) {
+    if (i || isDedicated) {
         cls.state = ca_dedicated;
-        if (i != (com_argc - 1)) {
+        if (i && i != (com_argc - 1)) {
             svs.maxclients = static_cast<int>(strtol(com_argv[i + 1], nullptr, 10));
         } else
             svs.maxclients = 8;
@@ -778,6 +778,25 @@ void Host_InitVCR(quakeparms_t *parms) {
 
 }
 
+/*
+====================
+Host_PreloadMaps
+
+-preload e1m1 e1m2 ... loads those maps below the host hunk mark, so they
+stay resident across map changes, and are shared copy on write by every
+-instances server. Maps that aren't listed are loaded by each instance on
+its own, unless -bakedir is given.
+====================
+*/
+static void Host_PreloadMaps() {
+    const auto i = COM_CheckParm("-preload");
+    if (!i)
+        return;
+
+    for (auto j = i + 1; j < com_argc && com_argv[j][0] != '-' && com_argv[j][0] != '+'; j++)
+        Mod_PinModel(va("maps/%s.bsp", com_argv[j]));
+}
+
 /*
 ====================
 Host_Init
@@ -809,7 +828,9 @@ void Host_Init(quakeparms_t *parms) {
     Host_InitVCR(parms);
     COM_Init();
     Host_InitLocal();
-    W_LoadWadFile("gfx.wad");
+    Thread_Init();
+    if (cls.state != ca_dedicated)
+        W_LoadWadFile("gfx.wad");        // only ever drawn from
     Key_Init();
     Con_Init();
     M_Init();
@@ -859,6 +880,8 @@ void Host_Init(quakeparms_t *parms) {
 #endif
     }
 
+    Host_PreloadMaps();
+
     Cbuf_InsertText("exec quake.rc\n");
 
     hunkAllocName<void *>(0, "-HOST_HUNKLEVEL-");
@@ -894,6 +917,7 @@ void Host_Shutdown() {
 
 //    CDAudio_Shutdown();
     NET_Shutdown();
+    Thread_Shutdown();
     S_Shutdown();
     IN_Shutdown();
 
@@ -118,6 +118,7 @@ void Host_God_f() {
         return;
 
     sv_player->v.flags = (int) sv_player->v.flags ^ FL_GODMODE;
+    ED_CHANGED(sv_player);
     if (!((int) sv_player->v.flags & FL_GODMODE))
         SV_ClientPrintf("godmode OFF\n");
     else
@@ -134,6 +135,7 @@ void Host_Notarget_f() {
         return;
 
     sv_player->v.flags = (int) sv_player->v.flags ^ FL_NOTARGET;
+    ED_CHANGED(sv_player);
     if (!((int) sv_player->v.flags & FL_NOTARGET))
         SV_ClientPrintf("notarget OFF\n");
     else
@@ -160,6 +162,7 @@ void Host_Noclip_f() {
         sv_player->v.movetype = MOVETYPE_WALK;
         SV_ClientPrintf("noclip OFF\n");
     }
+    ED_CHANGED(sv_player);
 }
 
 /*
@@ -185,6 +188,7 @@ void Host_Fly_f() {
         sv_player->v.movetype = MOVETYPE_WALK;
         SV_ClientPrintf("flymode OFF\n");
     }
+    ED_CHANGED(sv_player);
 }
 
 
@@ -909,6 +913,7 @@ void Host_Please_f (void)
             cl->privileged = false;
             cl->edict->v.flags = (int)cl->edict->v.flags & ~(FL_GODMODE|FL_NOTARGET);
             cl->edict->v.movetype = MOVETYPE_WALK;
+            ED_CHANGED(cl->edict);
             noclip_anglehack = false;
         }
         else
@@ -929,6 +934,7 @@ void Host_Please_f (void)
                 cl->privileged = false;
                 cl->edict->v.flags = (int)cl->edict->v.flags & ~(FL_GODMODE|FL_NOTARGET);
                 cl->edict->v.movetype = MOVETYPE_WALK;
+                ED_CHANGED(cl->edict);
                 noclip_anglehack = false;
             }
             else
@@ -1195,9 +1201,10 @@ void Host_Spawn_f() {
         ent = host_client->edict;
 
         memset(&ent->v, 0, progs->entityfields * 4);
+        ED_CHANGED(ent);
         ent->v.colormap = NUM_FOR_EDICT(ent);
         ent->v.team = (host_client->colors & 15) + 1;
-        ent->v.netname = getOffsetByString(host_client->name);
+        ent->v.netname = newString(host_client->name);
 
         // copy spawn parms out of the client_t
 
@@ -1278,6 +1285,7 @@ void Host_Spawn_f() {
 
     MSG_WriteAngles(&host_client->message, {ent->v.angles[0], ent->v.angles[1], 0});
 
+    SV_SetIdealPitch();
     SV_WriteClientdataToMessage(sv_player, &host_client->message);
 
     MSG_WriteByte(&host_client->message, svc_signonnum);
@@ -1444,7 +1452,7 @@ void Host_Give_f() {
 
         case 's':
             if (rogue) {
-                val = GetEdictFieldValue(sv_player, "ammo_shells1");
+                val = GetEdictFieldValue(sv_player, eval_ammo_shells1);
                 if (val)
                     val->_float = v;
             }
@@ -1453,7 +1461,7 @@ void Host_Give_f() {
             break;
         case 'n':
             if (rogue) {
-                val = GetEdictFieldValue(sv_player, "ammo_nails1");
+                val = GetEdictFieldValue(sv_player, eval_ammo_nails1);
                 if (val) {
                     val->_float = v;
                     if (sv_player->v.weapon <= IT_LIGHTNING)
@@ -1465,7 +1473,7 @@ void Host_Give_f() {
             break;
         case 'l':
             if (rogue) {
-                val = GetEdictFieldValue(sv_player, "ammo_lava_nails");
+                val = GetEdictFieldValue(sv_player, eval_ammo_lava_nails);
                 if (val) {
                     val->_float = v;
                     if (sv_player->v.weapon > IT_LIGHTNING)
@@ -1475,7 +1483,7 @@ void Host_Give_f() {
             break;
         case 'r':
             if (rogue) {
-                val = GetEdictFieldValue(sv_player, "ammo_rockets1");
+                val = GetEdictFieldValue(sv_player, eval_ammo_rockets1);
                 if (val) {
                     val->_float = v;
                     if (sv_player->v.weapon <= IT_LIGHTNING)
@@ -1487,7 +1495,7 @@ void Host_Give_f() {
             break;
         case 'm':
             if (rogue) {
-                val = GetEdictFieldValue(sv_player, "ammo_multi_rockets");
+                val = GetEdictFieldValue(sv_player, eval_ammo_multi_rockets);
                 if (val) {
                     val->_float = v;
                     if (sv_player->v.weapon > IT_LIGHTNING)
@@ -1500,7 +1508,7 @@ void Host_Give_f() {
             break;
         case 'c':
             if (rogue) {
-                val = GetEdictFieldValue(sv_player, "ammo_cells1");
+                val = GetEdictFieldValue(sv_player, eval_ammo_cells1);
                 if (val) {
                     val->_float = v;
                     if (sv_player->v.weapon <= IT_LIGHTNING)
@@ -1512,7 +1520,7 @@ void Host_Give_f() {
             break;
         case 'p':
             if (rogue) {
-                val = GetEdictFieldValue(sv_player, "ammo_plasma");
+                val = GetEdictFieldValue(sv_player, eval_ammo_plasma);
                 if (val) {
                     val->_float = v;
                     if (sv_player->v.weapon > IT_LIGHTNING)
@@ -23,6 +23,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // on the same machine.
 
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <unistd.h>
 #include "quakedef.hpp"
 #include "r_local.hpp"
 
@@ -33,12 +36,20 @@ void Mod_LoadSpriteModel(model_t *mod, void *buffer);
 
 void Mod_LoadBrushModel(model_t *mod, void *buffer);
 
+static void Mod_SetupSubmodels(model_t *mod);
+
+static auto Mod_LoadBaked(model_t *mod) -> bool;
+
+static void Mod_BakeModel(model_t *mod, int mark);
+
 void Mod_LoadAliasModel(model_t *mod, void *buffer);
 
 auto Mod_LoadModel(model_t *mod, qboolean crash) -> model_t *;
 
 byte mod_novis[MAX_MAP_LEAFS / 8];
 
+static char mod_bakedir[MAX_OSPATH];    // -bakedir, empty to not bake maps
+
 #define    MAX_MOD_KNOWN    256
 model_t mod_known[MAX_MOD_KNOWN];
 int mod_numknown;
@@ -55,6 +66,9 @@ Mod_Init
 */
 void Mod_Init() {
     memset(mod_novis, 0xff, sizeof(mod_novis));
+
+    if (const auto i = COM_CheckParm("-bakedir"); i && i < com_argc - 1)
+        Q_strncpy(mod_bakedir, com_argv[i + 1], sizeof(mod_bakedir) - 1);
 }
 
 /*
@@ -163,7 +177,13 @@ void Mod_ClearAll() {
 
 
     for (i = 0, mod = mod_known; i < mod_numknown; i++, mod++) {
+        if (mod->pinned)
+            continue;
         mod->needload = NL_UNREFERENCED;
+        if (mod->baked) {
+            Sys_FileUnmap(mod->baked, mod->bakedsize);
+            mod->baked = nullptr;
+        }
 //FIX FOR CACHE_ALLOC ERRORS:
         if (mod->type == mod_sprite) mod->cache.data = nullptr;
     }
@@ -246,10 +266,20 @@ auto Mod_LoadModel(model_t *mod, qboolean crash) -> model_t * {
             return mod;
         }
     } else {
-        if (mod->needload == NL_PRESENT)
+        if (mod->needload == NL_PRESENT) {
+            // another map may have taken the inline model names since
+            if (mod->pinned)
+                Mod_SetupSubmodels(mod);
             return mod;
+        }
     }
 
+//
+// a map baked by an earlier load is mapped instead of parsed
+//
+    if (Mod_LoadBaked(mod))
+        return mod;
+
 //
 // because the world is so huge, load it one piece at a time
 //
@@ -309,6 +339,24 @@ auto Mod_ForName(std::string_view name, qboolean crash) -> model_t * {
     return Mod_LoadModel(mod, crash);
 }
 
+/*
+==================
+Mod_PinModel
+
+Loads a map that Mod_ClearAll will leave alone, so a server can change
+back to it without reading it again. Only call before the host hunk mark.
+==================
+*/
+void Mod_PinModel(std::string_view name) {
+    auto *mod = Mod_ForName(name, false);
+
+    if (!mod || mod->type != mod_brush) {
+        Con_Printf("Couldn't preload %s\n", std::string(name).c_str());
+        return;
+    }
+    mod->pinned = true;
+}
+
 
 /*
 ===============================================================================
@@ -318,6 +366,42 @@ auto Mod_ForName(std::string_view name, qboolean crash) -> model_t * {
 ===============================================================================
 */
 
+texture_t *r_notexture_mip;
+
+/*
+==================
+R_InitTextures
+
+Brush models fall back on r_notexture_mip, so this is here for the
+dedicated server as well as the renderer
+==================
+*/
+void R_InitTextures() {
+    int x = 0, y = 0, m = 0;
+    byte *dest = nullptr;
+
+// create a simple checkerboard texture for the default
+    r_notexture_mip = hunkAllocName<decltype(r_notexture_mip)>(sizeof(texture_t) + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2,
+                                                               "notexture");
+
+    r_notexture_mip->width = r_notexture_mip->height = 16;
+    r_notexture_mip->offsets[0] = sizeof(texture_t);
+    r_notexture_mip->offsets[1] = r_notexture_mip->offsets[0] + 16 * 16;
+    r_notexture_mip->offsets[2] = r_notexture_mip->offsets[1] + 8 * 8;
+    r_notexture_mip->offsets[3] = r_notexture_mip->offsets[2] + 4 * 4;
+
+    for (m = 0; m < 4; m++) {
+        dest = (byte *) r_notexture_mip + r_notexture_mip->offsets[m];
+        for (y = 0; y < (16 >> m); y++)
+            for (x = 0; x < (16 >> m); x++) {
+                if ((y < (8 >> m)) ^ (x < (8 >> m)))
+                    *dest++ = 0;
+                else
+                    *dest++ = 0xff;
+            }
+    }
+}
+
 byte *mod_base;
 
 template <typename DataType>
@@ -819,6 +903,30 @@ void Mod_LoadLeafs(lump_t *l) {
     }
 }
 
+/*
+=================
+Mod_MakeTraceNodes
+
+Folds the planes into a copy of the clipnodes, aligned to cache lines
+=================
+*/
+static auto Mod_MakeTraceNodes(const dclipnode_t *in, int count, const mplane_t *planes) -> mclipnode_t * {
+    auto *mem = hunkAllocName<byte *>(count * sizeof(mclipnode_t) + 63, loadname);
+    auto *out = reinterpret_cast<mclipnode_t *>((reinterpret_cast<std::uintptr_t>(mem) + 63) & ~std::uintptr_t{63});
+
+    for (int i = 0; i < count; i++) {
+        const auto *plane = planes + in[i].planenum;
+        out[i].normal = plane->normal;
+        out[i].dist = plane->dist;
+        out[i].type = plane->type;
+        out[i].children[0] = in[i].children[0];
+        out[i].children[1] = in[i].children[1];
+        out[i].pad = 0;
+    }
+
+    return out;
+}
+
 /*
 =================
 Mod_LoadClipnodes
@@ -865,6 +973,9 @@ void Mod_LoadClipnodes(lump_t *l) {
     for (i = 0; i < count; i++, out++, in++) {
         std::memcpy(out, in, sizeof(dclipnode_t));
     }
+
+    loadmodel->hulls[1].nodes = loadmodel->hulls[2].nodes
+            = Mod_MakeTraceNodes(loadmodel->clipnodes, count, loadmodel->planes);
 }
 
 /*
@@ -901,6 +1012,8 @@ void Mod_MakeHull0() {
                 out->children[j] = child - loadmodel->nodes;
         }
     }
+
+    hull->nodes = Mod_MakeTraceNodes(hull->clipnodes, count, hull->planes);
 }
 
 /*
@@ -1007,9 +1120,9 @@ Mod_LoadBrushModel
 =================
 */
 void Mod_LoadBrushModel(model_t *mod, void *buffer) {
-    int i = 0, j = 0;
+    int i = 0;
     dheader_t *header = nullptr;
-    dmodel_t *bm = nullptr;
+    const auto mark = Hunk_LowMark();
 
     loadmodel->type = mod_brush;
 
@@ -1048,14 +1161,24 @@ void Mod_LoadBrushModel(model_t *mod, void *buffer) {
     mod->numframes = 2;        // regular and alternate animation
     mod->flags = 0;
 
-//
-// set up the submodels (FIXME: this is confusing)
-//
-    for (i = 0; i < mod->numsubmodels; i++) {
-        bm = &mod->submodels[i];
+    Mod_BakeModel(mod, mark);
+    Mod_SetupSubmodels(mod);
+}
+
+/*
+=================
+Mod_SetupSubmodels
+
+Points the inline models *1, *2... at the submodels of a world
+(FIXME: this is confusing)
+=================
+*/
+static void Mod_SetupSubmodels(model_t *mod) {
+    for (int i = 0; i < mod->numsubmodels; i++) {
+        const auto *bm = &mod->submodels[i];
 
         mod->hulls[0].firstclipnode = bm->headnode[0];
-        for (j = 1; j < MAX_MAP_HULLS; j++) {
+        for (int j = 1; j < MAX_MAP_HULLS; j++) {
             mod->hulls[j].firstclipnode = bm->headnode[j];
             mod->hulls[j].lastclipnode = mod->numclipnodes - 1;
         }
@@ -1073,10 +1196,12 @@ void Mod_LoadBrushModel(model_t *mod, void *buffer) {
             char name[10];
 
             sprintf(name, "*%i", i + 1);
-            loadmodel = Mod_FindName(name);
-            *loadmodel = *mod;
-            strcpy(loadmodel->name, name);
-            mod = loadmodel;
+            auto *submodel = Mod_FindName(name);
+            *submodel = *mod;
+            strcpy(submodel->name, name);
+            submodel->pinned = false;
+            submodel->baked = nullptr;
+            mod = submodel;
         }
     }
 }
@@ -1084,6 +1209,474 @@ void Mod_LoadBrushModel(model_t *mod, void *buffer) {
 /*
 ==============================================================================
 
+BAKED BRUSH MODELS
+
+With -bakedir <path>, a brush model is baked there the first time it's
+loaded: every hunk block it was loaded into, as they were left, with its
+pointers turned into offsets and a list of where they are. Loading it
+again maps the file copy on write and puts the pointers back, which only
+touches the pages holding nodes, leafs, surfaces and texinfo. The
+lighting, vis, vertexes, clipnodes and texture pixels stay shared between
+every server on the host that has the map up.
+
+A baked model is used while the .bsp or pak it was baked from has the
+same size and time, and only if it was baked by an engine with the same
+structures. Every pointer is checked to land on an element of the array
+it belongs to, but the rest is trusted as much as a .bsp is, and a file
+truncated while it's mapped takes the server down: the directory should
+be writable by nobody but the servers.
+
+==============================================================================
+*/
+
+#define    BAKEDHEADER    (('E'<<24)+('K'<<16)+('A'<<8)+'B')
+#define    BAKED_VERSION    1
+
+// an encoded pointer to r_notexture_mip, which isn't in the model
+#define    BAKED_NOTEXTURE    (~std::uintptr_t{0})
+
+typedef struct {
+    int ident;
+    int version;
+    int pointersize;
+    int structsizes[6];        // model_t, mnode_t, mleaf_t, msurface_t, mtexinfo_t, texture_t
+    int filesize;            // of the .bsp it was baked from
+    int filetime;
+    int imageofs;            // hunk blocks, as far into a page as they were into a cache line
+    int imagesize;
+    int modelofs;            // the model_t, after the blocks
+    int relocofs;            // image offsets of the pointers to put back
+    int numrelocs;
+} bakedheader_t;
+
+static const int baked_structsizes[6] = {sizeof(model_t), sizeof(mnode_t), sizeof(mleaf_t),
+                                         sizeof(msurface_t), sizeof(mtexinfo_t), sizeof(texture_t)};
+
+/*
+=================
+Mod_BakedPath
+
+Empty if there is no -bakedir, or the model isn't a map
+=================
+*/
+static auto Mod_BakedPath(const model_t *mod) -> std::string {
+    const std::string_view name = mod->name;
+
+    if (!mod_bakedir[0] || !name.ends_with(".bsp"))
+        return {};
+
+    return fmt::sprintf("%s/%s/%s.baked", mod_bakedir, COM_FileBase(com_gamedir), name);
+}
+
+/*
+=================
+Mod_BakeModel
+
+Writes out the brush model that was just loaded above mark, before its
+submodels are set up. Anything it can't account for leaves it unbaked.
+=================
+*/
+static void Mod_BakeModel(model_t *mod, int mark) {
+    auto path = Mod_BakedPath(mod);
+    if (path.empty())
+        return;
+
+    int handle;
+    const auto filesize = COM_OpenFile(mod->name, &handle);
+    if (handle == -1)
+        return;
+    COM_CloseFile(handle);
+
+    const auto *lo = hunk_base + mark;
+    const auto *hi = hunk_base + hunk_low_used;
+    const auto *model = reinterpret_cast<const byte *>(mod);
+
+    bakedheader_t header{};
+    header.ident = BAKEDHEADER;
+    header.version = BAKED_VERSION;
+    header.pointersize = sizeof(void *);
+    memcpy(header.structsizes, baked_structsizes, sizeof(header.structsizes));
+    header.filesize = filesize;
+    header.filetime = com_filetime;
+    header.imageofs = ((sizeof(header) + 63) & ~63) + (reinterpret_cast<std::uintptr_t>(lo) & 63);
+    header.modelofs = static_cast<int>(((hi - lo) + 15) & ~15);
+    header.imagesize = header.modelofs + sizeof(model_t);
+
+    std::vector<byte> image(header.imagesize);
+    memcpy(image.data(), lo, hi - lo);
+    memcpy(image.data() + header.modelofs, mod, sizeof(model_t));
+
+    std::vector<int> relocs;
+    auto baked = true;
+    const auto reloc = [&](const void *field) {
+        const auto *f = static_cast<const byte *>(field);
+        const auto offset = f >= lo && f < hi ? f - lo : header.modelofs + (f - model);
+        const auto *p = *static_cast<const byte *const *>(field);
+
+        std::uintptr_t value;
+        if (!p)
+            value = 0;
+        else if (p == reinterpret_cast<const byte *>(r_notexture_mip))
+            value = BAKED_NOTEXTURE;
+        else if (p >= lo && p <= hi)
+            value = p - lo + 1;
+        else {
+            baked = false;
+            return;
+        }
+        memcpy(image.data() + offset, &value, sizeof(value));
+        relocs.push_back(static_cast<int>(offset));
+    };
+
+    reloc(&mod->submodels);
+    reloc(&mod->planes);
+    reloc(&mod->leafs);
+    reloc(&mod->vertexes);
+    reloc(&mod->edges);
+    reloc(&mod->nodes);
+    reloc(&mod->texinfo);
+    reloc(&mod->surfaces);
+    reloc(&mod->surfedges);
+    reloc(&mod->clipnodes);
+    reloc(&mod->marksurfaces);
+    reloc(&mod->textures);
+    reloc(&mod->visdata);
+    reloc(&mod->lightdata);
+    reloc(&mod->entities);
+    for (auto &hull: mod->hulls) {
+        reloc(&hull.clipnodes);
+        reloc(&hull.planes);
+        reloc(&hull.nodes);
+    }
+
+    for (int i = 0; i < mod->numnodes; i++) {
+        auto *node = &mod->nodes[i];
+        reloc(&node->parent);
+        reloc(&node->plane);
+        reloc(&node->children[0]);
+        reloc(&node->children[1]);
+    }
+    for (int i = 0; i < mod->numleafs; i++) {
+        auto *leaf = &mod->leafs[i];
+        reloc(&leaf->parent);
+        reloc(&leaf->compressed_vis);
+        reloc(&leaf->firstmarksurface);
+    }
+    for (int i = 0; i < mod->numsurfaces; i++) {
+        auto *surf = &mod->surfaces[i];
+        reloc(&surf->plane);
+        reloc(&surf->texinfo);
+        reloc(&surf->samples);
+    }
+    for (int i = 0; i < mod->numtexinfo; i++)
+        reloc(&mod->texinfo[i].texture);
+    for (int i = 0; i < mod->nummarksurfaces; i++)
+        reloc(&mod->marksurfaces[i]);
+    if (mod->textures) {
+        for (int i = 0; i < mod->numtextures; i++) {
+            reloc(&mod->textures[i]);
+            if (auto *tx = mod->textures[i]) {
+                reloc(&tx->anim_next);
+                reloc(&tx->alternate_anims);
+            }
+        }
+    }
+
+    if (!baked) {
+        Con_DPrintf("Mod_BakeModel: %s points outside itself\n", mod->name);
+        return;
+    }
+
+    header.relocofs = (header.imageofs + header.imagesize + 3) & ~3;
+    header.numrelocs = static_cast<int>(relocs.size());
+
+    // written aside and renamed into place, servers loading the same map
+    // at once may all be baking it
+    COM_CreatePath(path.data());
+    const auto temp = fmt::sprintf("%s.%i", path, getpid());
+    auto *f = fopen(temp.c_str(), "wb");
+    if (!f)
+        return;
+
+    static const byte pad[64]{};
+    auto ok = fwrite(&header, sizeof(header), 1, f) == 1
+              && fwrite(pad, header.imageofs - sizeof(header), 1, f) == 1
+              && fwrite(image.data(), image.size(), 1, f) == 1
+              && fwrite(pad, header.relocofs - header.imageofs - header.imagesize, 1, f) <= 1
+              && fwrite(relocs.data(), sizeof(int), relocs.size(), f) == relocs.size();
+    ok = fclose(f) == 0 && ok;
+
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return;
+    }
+    Con_DPrintf("Baked %s, %i KB\n", mod->name, header.imagesize / 1024);
+}
+
+// true if p is count whole Ts inside the image, or null for none
+template<typename T>
+static auto Mod_BakedArray(const T *p, int count, const byte *image, int imagesize) -> bool {
+    if (count < 0)
+        return false;
+    if (!p)
+        return count == 0;
+
+    const auto ofs = reinterpret_cast<std::uintptr_t>(p) - reinterpret_cast<std::uintptr_t>(image);
+    return ofs <= static_cast<std::uintptr_t>(imagesize)
+           && static_cast<std::uintptr_t>(count) <= (imagesize - ofs) / sizeof(T)
+           && reinterpret_cast<std::uintptr_t>(p) % alignof(T) == 0;
+}
+
+// true if p is one of the count Ts at array
+template<typename T>
+static auto Mod_BakedElement(const T *p, const T *array, int count) -> bool {
+    const auto ofs = reinterpret_cast<std::uintptr_t>(p) - reinterpret_cast<std::uintptr_t>(array);
+    return ofs % sizeof(T) == 0 && ofs / sizeof(T) < static_cast<std::uintptr_t>(count);
+}
+
+// a clipnode child is contents, or a node of the same hull
+static auto Mod_BakedChild(int child, int lastclipnode) -> bool {
+    return child <= lastclipnode && child >= CONTENTS_CURRENT_DOWN;
+}
+
+/*
+=================
+Mod_CheckBaked
+
+Goes over a baked model that has had its pointers put back, before any of
+them are followed outside of here. Every pointer has already been checked
+to be inside the image.
+=================
+*/
+static auto Mod_CheckBaked(const model_t *m, const byte *image, int imagesize) -> bool {
+    if (m->type != mod_brush
+        || m->numleafs < 1 || m->numleafs > MAX_MAP_LEAFS
+        || m->numnodes < 1
+        || !Mod_BakedArray(m->submodels, m->numsubmodels, image, imagesize) || m->numsubmodels < 1
+        || !Mod_BakedArray(m->planes, m->numplanes, image, imagesize)
+        || !Mod_BakedArray(m->leafs, m->numleafs, image, imagesize)
+        || !Mod_BakedArray(m->vertexes, m->numvertexes, image, imagesize)
+        || !Mod_BakedArray(m->edges, m->numedges + 1, image, imagesize)
+        || !Mod_BakedArray(m->nodes, m->numnodes, image, imagesize)
+        || !Mod_BakedArray(m->texinfo, m->numtexinfo, image, imagesize)
+        || !Mod_BakedArray(m->surfaces, m->numsurfaces, image, imagesize)
+        || !Mod_BakedArray(m->surfedges, m->numsurfedges, image, imagesize)
+        || !Mod_BakedArray(m->clipnodes, m->numclipnodes, image, imagesize)
+        || !Mod_BakedArray(m->marksurfaces, m->nummarksurfaces, image, imagesize)
+        || (m->textures && !Mod_BakedArray(m->textures, m->numtextures, image, imagesize))
+        || (m->lightdata && !Mod_BakedArray(m->lightdata, 1, image, imagesize))
+        || (m->visdata && !Mod_BakedArray(m->visdata, 1, image, imagesize))
+        || !Mod_BakedArray(m->entities, 1, image, imagesize) || !m->entities
+        || !memchr(m->entities, 0, image + imagesize - reinterpret_cast<const byte *>(m->entities)))
+        return false;
+
+    const auto numtextures = m->textures ? m->numtextures : 0;
+    const auto isTexture = [&](const texture_t *tx) {
+        for (int i = 0; i < numtextures; i++)
+            if (tx == m->textures[i])
+                return true;
+        return false;
+    };
+
+    for (int i = 0; i < numtextures; i++) {
+        const auto *tx = m->textures[i];
+        if (!tx)
+            continue;
+        if (!Mod_BakedArray(tx, 1, image, imagesize)
+            || tx->width > 4096 || tx->height > 4096
+            || (tx->anim_next && !isTexture(tx->anim_next))
+            || (tx->alternate_anims && !isTexture(tx->alternate_anims)))
+            return false;
+        const auto end = reinterpret_cast<const byte *>(tx) + sizeof(texture_t) + tx->width * tx->height / 64 * 85;
+        if (end > image + imagesize)
+            return false;
+        for (const auto offset: tx->offsets)
+            if (offset < sizeof(texture_t) || reinterpret_cast<const byte *>(tx) + offset > end)
+                return false;
+    }
+
+    for (int i = 0; i < m->numtexinfo; i++) {
+        const auto *tex = m->texinfo[i].texture;
+        if (tex != r_notexture_mip && (!tex || !isTexture(tex)))
+            return false;
+    }
+
+    for (int i = 0; i < m->numsurfaces; i++) {
+        const auto *surf = &m->surfaces[i];
+        if (!Mod_BakedElement(surf->plane, m->planes, m->numplanes)
+            || !Mod_BakedElement(surf->texinfo, m->texinfo, m->numtexinfo)
+            || surf->firstedge < 0 || surf->numedges < 0 || surf->firstedge > m->numsurfedges - surf->numedges
+            || (surf->samples && !Mod_BakedArray(surf->samples, 1, image, imagesize)))
+            return false;
+        for (const auto *spot: surf->cachespots)
+            if (spot)
+                return false;
+    }
+
+    for (int i = 0; i < m->nummarksurfaces; i++)
+        if (!Mod_BakedElement(m->marksurfaces[i], m->surfaces, m->numsurfaces))
+            return false;
+
+    for (int i = 0; i < m->numnodes; i++) {
+        const auto *node = &m->nodes[i];
+        if (node->contents < 0
+            || (node->parent && !Mod_BakedElement(node->parent, m->nodes, m->numnodes))
+            || !Mod_BakedElement(node->plane, m->planes, m->numplanes)
+            || node->firstsurface + node->numsurfaces > m->numsurfaces)
+            return false;
+        for (const auto *child: node->children)
+            if (!Mod_BakedElement(child, m->nodes, m->numnodes)
+                && !Mod_BakedElement(reinterpret_cast<const mleaf_t *>(child), m->leafs, m->numleafs))
+                return false;
+    }
+
+    for (int i = 0; i < m->numleafs; i++) {
+        const auto *leaf = &m->leafs[i];
+        if (leaf->contents >= 0
+            || (leaf->parent && !Mod_BakedElement(leaf->parent, m->nodes, m->numnodes))
+            || leaf->efrags
+            || (leaf->compressed_vis && !Mod_BakedArray(leaf->compressed_vis, 1, image, imagesize))
+            || leaf->nummarksurfaces < 0
+            || (leaf->nummarksurfaces && !Mod_BakedElement(leaf->firstmarksurface, m->marksurfaces, m->nummarksurfaces))
+            || (leaf->nummarksurfaces
+                && leaf->firstmarksurface - m->marksurfaces > m->nummarksurfaces - leaf->nummarksurfaces))
+            return false;
+    }
+
+    for (int i = 0; i < MAX_MAP_HULLS; i++) {
+        const auto *hull = &m->hulls[i];
+        if (!hull->clipnodes && !hull->nodes)
+            continue;        // not used
+        const auto count = hull->lastclipnode + 1;
+        if (hull->firstclipnode < 0 || hull->firstclipnode >= count
+            || !Mod_BakedArray(hull->clipnodes, count, image, imagesize) || !hull->clipnodes
+            || !Mod_BakedArray(hull->nodes, count, image, imagesize) || !hull->nodes
+            || hull->planes != m->planes)
+            return false;
+        for (int j = 0; j < count; j++) {
+            const auto *in = &hull->clipnodes[j];
+            const auto *node = &hull->nodes[j];
+            if (in->planenum < 0 || in->planenum >= m->numplanes || node->type < 0
+                || !Mod_BakedChild(in->children[0], hull->lastclipnode)
+                || !Mod_BakedChild(in->children[1], hull->lastclipnode)
+                || !Mod_BakedChild(node->children[0], hull->lastclipnode)
+                || !Mod_BakedChild(node->children[1], hull->lastclipnode))
+                return false;
+        }
+    }
+
+    for (int i = 0; i < m->numsubmodels; i++) {
+        const auto *bm = &m->submodels[i];
+        if (bm->firstface < 0 || bm->numfaces < 0 || bm->firstface > m->numsurfaces - bm->numfaces
+            || bm->visleafs < 0 || bm->visleafs >= m->numleafs)
+            return false;
+        for (int j = 0; j < MAX_MAP_HULLS; j++) {
+            const auto *hull = &m->hulls[j];
+            if ((hull->clipnodes || hull->nodes) && (bm->headnode[j] < 0 || bm->headnode[j] > hull->lastclipnode))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+=================
+Mod_LoadBaked
+
+Maps the model from the cache directory if it was baked from the same
+file, and points it back at itself. Submodels are set up as after a load.
+=================
+*/
+static auto Mod_LoadBaked(model_t *mod) -> bool {
+    const auto path = Mod_BakedPath(mod);
+    if (path.empty())
+        return false;
+
+    int handle;
+    const auto filesize = COM_OpenFile(mod->name, &handle);
+    if (handle == -1)
+        return false;
+    COM_CloseFile(handle);
+
+    int size;
+    auto *base = static_cast<byte *>(Sys_FileMap(path.c_str(), &size));
+    if (!base)
+        return false;
+
+    const auto *header = reinterpret_cast<const bakedheader_t *>(base);
+    if (size < sizeof(*header)
+        || header->ident != BAKEDHEADER
+        || header->version != BAKED_VERSION
+        || header->pointersize != sizeof(void *)
+        || memcmp(header->structsizes, baked_structsizes, sizeof(header->structsizes)) != 0
+        || header->filesize != filesize
+        || header->filetime != com_filetime
+        || header->imageofs < static_cast<int>(sizeof(*header)) || header->imagesize < 0
+        || header->modelofs < 0
+        || header->modelofs > header->imagesize - static_cast<int>(sizeof(model_t))
+        || header->imageofs > header->relocofs - header->imagesize
+        || header->relocofs % sizeof(int) || header->numrelocs < 0
+        || header->relocofs + static_cast<std::size_t>(header->numrelocs) * sizeof(int) > size) {
+        Sys_FileUnmap(base, size);
+        return false;
+    }
+
+    auto *image = base + header->imageofs;
+    const auto *relocs = reinterpret_cast<const int *>(base + header->relocofs);
+    for (int i = 0; i < header->numrelocs; i++) {
+        if (relocs[i] < 0 || relocs[i] > header->imagesize - static_cast<int>(sizeof(std::uintptr_t))
+            || reinterpret_cast<std::uintptr_t>(image + relocs[i]) % alignof(std::uintptr_t)) {
+            Sys_FileUnmap(base, size);
+            return false;
+        }
+
+        auto *field = image + relocs[i];
+
+        std::uintptr_t value;
+        memcpy(&value, field, sizeof(value));
+        if (value == BAKED_NOTEXTURE)
+            value = reinterpret_cast<std::uintptr_t>(r_notexture_mip);
+        else if (value && value - 1 < static_cast<std::uintptr_t>(header->imagesize))
+            value += reinterpret_cast<std::uintptr_t>(image) - 1;
+        else if (value) {
+            Sys_FileUnmap(base, size);
+            return false;
+        }
+        memcpy(field, &value, sizeof(value));
+    }
+
+    const auto *baked = reinterpret_cast<const model_t *>(image + header->modelofs);
+    if (reinterpret_cast<std::uintptr_t>(baked) % alignof(model_t)
+        || !Mod_CheckBaked(baked, image, header->imagesize)) {
+        Con_Printf("%s is corrupt, not using it\n", path.c_str());
+        Sys_FileUnmap(base, size);
+        return false;
+    }
+
+    const auto pinned = mod->pinned;
+    memcpy(mod, baked, sizeof(model_t));
+    mod->cache = {};
+    mod->pinned = pinned;
+    mod->needload = NL_PRESENT;
+    mod->baked = base;
+    mod->bakedsize = size;
+
+    if (mod->textures) {
+        for (int i = 0; i < mod->numtextures; i++) {
+            if (auto *tx = mod->textures[i]; tx && !Q_strncmp(tx->name, "sky", 3))
+                R_InitSky(tx);
+        }
+    }
+
+    Mod_SetupSubmodels(mod);
+
+    return true;
+}
+
+/*
+==============================================================================
+
 ALIAS MODELS
 
 ==============================================================================
@@ -158,6 +158,18 @@ typedef struct mleaf_s {
     byte ambient_sound_level[NUM_AMBIENTS];
 } mleaf_t;
 
+// a clipnode with its plane folded in, so a trace touches one 32 byte
+// record per node
+typedef struct mclipnode_s {
+    vec3 normal;
+    float dist;
+    int type;            // plane type, the axial ones test a single coordinate
+    int children[2];    // negative numbers are contents
+    int pad;
+} mclipnode_t;
+
+static_assert(sizeof(mclipnode_t) == 32);
+
 // !!! if this is changed, it must be changed in asm_i386.h too !!!
 typedef struct {
     dclipnode_t *clipnodes;
@@ -166,6 +178,7 @@ typedef struct {
     int lastclipnode;
     vec3 clip_mins;
     vec3 clip_maxs;
+    mclipnode_t *nodes;        // clipnodes and planes as the traces read them
 } hull_t;
 
 /*
@@ -285,6 +298,7 @@ typedef enum {
 typedef struct model_s {
     char name[MAX_QPATH];
     qboolean needload;        // bmodels and sprites don't cache normally
+    qboolean pinned;        // loaded below the host hunk mark, kept across maps
 
     modtype_t type;
     int numframes;
@@ -345,6 +359,9 @@ typedef struct model_s {
     byte *lightdata;
     char *entities;
 
+    byte *baked;        // the bake cache mapping this model lives in, if any
+    int bakedsize;
+
 //
 // additional model data
 //
@@ -360,6 +377,8 @@ void Mod_ClearAll(void);
 
 model_t *Mod_ForName(std::string_view name, qboolean crash);
 
+void Mod_PinModel(std::string_view name);
+
 void *Mod_Extradata(model_t *mod);    // handles caching
 void Mod_TouchModel(char *name);
 
@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // net.h -- quake's interface to the networking layer
 #pragma once
 
+#include <vector>
 #include "common.hpp"
 
 struct qsockaddr {
@@ -46,6 +47,24 @@ struct qsockaddr {
 
 #define NET_PROTOCOL_VERSION    3
 
+// Reliable messages are sent in MAX_DATAGRAM fragments, each acked by the
+// other end. Originally only one fragment could be unacked at a time; when
+// both ends offer a window in the connect handshake, up to that many can
+// be in flight instead. The ack for a windowed connection carries the next
+// sequence the receiver is missing, followed by a long with bit n set if
+// the fragment n + 1 after that has arrived, and only the fragments still
+// missing are resent.
+#define NET_WINDOW            16    // most reliable fragments in flight
+#define NET_MINRTO            0.1    // bounds of the retransmit timeout
+#define NET_MAXRTO            1.0    // the original fixed timeout
+
+// A server can have its clients share the listening socket instead of
+// opening one for each. Whatever arrives on it is then read NET_BATCH
+// datagrams at a time and handed to the connection its address belongs
+// to, and what the connections send is queued and written in batches.
+#define NET_BATCH            64    // datagrams read or written by one call
+#define NET_MAXQUEUED        256    // read but not yet taken by a connection
+
 // This is the network info/connection protocol.  It is used to find Quake
 // servers, get info about them, and connect to them.  Once connected, the
 // Quake game protocol (documented elsewhere) is used.
@@ -58,6 +77,8 @@ struct qsockaddr {
 // CCREQ_CONNECT
 //		string	game_name				"QUAKE"
 //		byte	net_protocol_version	NET_PROTOCOL_VERSION
+//		byte	game_protocol			highest game protocol, newer clients only
+//		byte	window					reliable fragments in flight, newer clients only
 //
 // CCREQ_SERVER_INFO
 //		string	game_name				"QUAKE"
@@ -73,6 +94,7 @@ struct qsockaddr {
 //
 // CCREP_ACCEPT
 //		long	port
+//		byte	window					only if the client offered one
 //
 // CCREP_REJECT
 //		string	reason
@@ -118,6 +140,22 @@ struct qsockaddr {
 #define CCREP_PLAYER_INFO    0x84
 #define CCREP_RULE_INFO        0x85
 
+typedef struct {
+    unsigned int sequence;
+    qboolean used;        // waiting for an ack, or for the fragments before it
+    qboolean eom;
+    qboolean resent;    // round trip times are only taken from fragments sent once
+    double sendTime;
+    int length;
+    byte data[MAX_DATAGRAM];
+} netfragment_t;
+
+typedef struct {
+    struct qsockaddr addr;
+    int length;
+    byte data[NET_DATAGRAMSIZE];
+} netpacket_t;
+
 typedef struct qsocket_s {
     struct qsocket_s *next;
     double connecttime;
@@ -147,6 +185,18 @@ typedef struct qsocket_s {
     struct qsockaddr addr;
     char address[NET_NAMELEN];
 
+    int protocol;        // highest game protocol the other end announced
+
+    int window;            // reliable fragments allowed in flight, 1 for stop and wait
+    double rto;            // retransmit timeout
+    double srtt;        // smoothed round trip time, 0 until the first sample
+    double rttvar;
+    netfragment_t sendFragments[NET_WINDOW];        // unacked, by sequence % NET_WINDOW
+    netfragment_t receiveFragments[NET_WINDOW];    // arrived ahead of receiveSequence
+
+    qboolean shared;            // uses the listening socket of its landriver
+    unsigned int drained;        // last drain of that socket it found nothing in
+
 } qsocket_t;
 
 extern qsocket_t *net_activeSockets;
@@ -193,6 +243,13 @@ typedef struct {
     int (*GetSocketPort)(struct qsockaddr *addr);
 
     int (*SetSocketPort)(struct qsockaddr *addr, int port);
+
+    // optional, for drivers that can move many datagrams in one call
+    int (*ListenSocket)(void);
+
+    int (*ReadBatch)(int socket, netpacket_t *packets, int count);
+
+    int (*WriteBatch)(int socket, netpacket_t *packets, int count);
 } net_landriver_t;
 
 #define    MAX_NET_DRIVERS        8
@@ -227,6 +284,14 @@ typedef struct {
 
     void (*Shutdown)(void);
 
+    void (*Flush)(void);    // optional, sends whatever has been queued
+
+    // optional, the sockets a sleeping server should wake up for, and a way
+    // to take in what arrives on them before the next frame
+    void (*WaitHandles)(std::vector<int> &handles);
+
+    void (*ReadAhead)(void);
+
     int controlSock;
 } net_driver_t;
 
@@ -330,6 +395,18 @@ int NET_SendUnreliableMessage(struct qsocket_s *sock, sizebuf_t *data);
 int NET_SendToAll(sizebuf_t *data, int blocktime);
 // This is a reliable *blocking* send to all attached clients.
 
+void NET_Flush(void);
+// sends the datagrams drivers have queued up, once all clients have been
+// written to for the frame
+
+void NET_WaitHandles(std::vector<int> &handles);
+// fills handles with the sockets a dedicated server can sleep on between
+// frames
+
+void NET_ReadAhead(void);
+// called when one of them is readable, so it can be read without waiting
+// for the next frame
+
 
 void NET_Close(struct qsocket_s *sock);
 // if a dead connection is returned by a get or send function, this function
@@ -38,7 +38,7 @@ struct _in_addr {
         struct {
             unsigned short s_w1, s_w2;
         } S_un_w;
-        unsigned long S_addr;
+        unsigned int S_addr;
     } S_un;
 };
 #define    s_addr    S_un.S_addr    /* can be used for most tcp & ip code */
@@ -53,7 +53,11 @@ struct _sockaddr_in {
 #endif
 #endif    // BAN_TEST
 
+#include <algorithm>
 #include <cmath>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include "quakedef.hpp"
 #include "net_dgrm.hpp"
 
@@ -169,6 +173,428 @@ void NET_Ban_f() {
 #endif
 
 
+/*
+===============================================================================
+
+SHARED LISTENING SOCKET
+
+===============================================================================
+*/
+
+// give new connections the listening socket instead of one of their own
+cvar_t net_sharesocket = {"net_sharesocket", "0"};
+
+// what has been read from a landriver's listening socket and not taken yet,
+// and what its connections have written and not been sent
+typedef struct {
+    int socket = -1;
+    unsigned int drains;            // times it has been read
+    unsigned int requestsDrained;    // last drain connection requests found nothing in
+    std::unordered_map<std::string_view, qsocket_t *> connections;    // by the bytes of their address
+    std::vector<netpacket_t> received;        // length -1 once taken
+    std::vector<qsocket_t *> receivedFor;    // nullptr for connection requests
+    int numreceived;
+    std::vector<netpacket_t> sending;
+    int numsending;
+} sharedsocket_t;
+
+static sharedsocket_t sharedSockets[MAX_NET_DRIVERS];
+
+static auto Datagram_AddrKey(struct qsockaddr *addr) -> std::string_view {
+    return {reinterpret_cast<const char *>(addr), sizeof(struct qsockaddr)};
+}
+
+/*
+==================
+Datagram_SharedSocket
+
+The queues of the landriver's listening socket, emptied if it has been
+reopened since, or nullptr if it isn't listening or can't batch
+==================
+*/
+static auto Datagram_SharedSocket(int landriver) -> sharedsocket_t * {
+    const auto *driver = &net_landrivers[landriver];
+    if (!driver->ListenSocket || !driver->ReadBatch || !driver->WriteBatch)
+        return nullptr;
+
+    const auto socket = driver->ListenSocket();
+    if (socket == -1)
+        return nullptr;
+
+    auto *shared = &sharedSockets[landriver];
+    if (shared->socket != socket) {
+        shared->socket = socket;
+        shared->connections.clear();
+        shared->received.resize(NET_MAXQUEUED);
+        shared->receivedFor.resize(NET_MAXQUEUED);
+        shared->numreceived = 0;
+        shared->sending.resize(NET_BATCH);
+        shared->numsending = 0;
+    }
+    return shared;
+}
+
+static void Datagram_FlushShared(sharedsocket_t *shared, int landriver) {
+    if (!shared->numsending)
+        return;
+
+    if (net_landrivers[landriver].WriteBatch(shared->socket, shared->sending.data(), shared->numsending) == -1)
+        Con_DPrintf("Write error\n");
+    shared->numsending = 0;
+}
+
+/*
+==================
+Datagram_Drain
+
+Sends what has been queued, then reads everything waiting on the socket
+and sorts it by the connection it came from
+==================
+*/
+static void Datagram_Drain(sharedsocket_t *shared, int landriver) {
+    Datagram_FlushShared(shared, landriver);
+
+    // drop what has been taken, and the oldest of the rest if a whole
+    // batch wouldn't fit after them
+    int waiting = 0;
+    for (int i = 0; i < shared->numreceived; i++) {
+        if (shared->received[i].length >= 0)
+            waiting++;
+    }
+
+    auto skip = std::max(waiting - (NET_MAXQUEUED - NET_BATCH), 0);
+    int kept = 0;
+    for (int i = 0; i < shared->numreceived; i++) {
+        if (shared->received[i].length < 0 || skip-- > 0)
+            continue;
+        if (kept != i) {
+            shared->received[kept] = shared->received[i];
+            shared->receivedFor[kept] = shared->receivedFor[i];
+        }
+        kept++;
+    }
+    shared->numreceived = kept;
+    shared->drains++;
+
+    while (shared->numreceived + NET_BATCH <= NET_MAXQUEUED) {
+        auto *packets = &shared->received[shared->numreceived];
+        const auto count = net_landrivers[landriver].ReadBatch(shared->socket, packets, NET_BATCH);
+        if (count == -1) {
+            Con_Printf("Read error\n");
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            auto *packet = &packets[i];
+            qsocket_t *sock = nullptr;
+
+            if (packet->length < static_cast<int>(sizeof(int)))
+                packet->length = -1;
+            else if (!(BigLong(*((int *) packet->data)) & NETFLAG_CTL)) {
+                // connection requests go to _Datagram_CheckNewConnections even
+                // from a connected address, so a lost accept can be asked again
+                const auto it = shared->connections.find(Datagram_AddrKey(&packet->addr));
+                if (it != shared->connections.end())
+                    sock = it->second;
+                else
+                    packet->length = -1;
+            }
+            shared->receivedFor[shared->numreceived++] = sock;
+        }
+
+        if (count < NET_BATCH)
+            return;
+    }
+}
+
+/*
+==================
+Datagram_ReadShared
+
+Reads like a landriver's Read, from the packets waiting for sock, or the
+connection requests if sock is nullptr. The socket itself is only read
+once the asker has already come up empty since the last time it was, so
+a frame that reads every connection drains it just once.
+==================
+*/
+static auto Datagram_ReadShared(int landriver, qsocket_t *sock, byte *buf, int len, struct qsockaddr *addr) -> int {
+    auto *shared = Datagram_SharedSocket(landriver);
+    if (!shared)
+        return 0;
+
+    auto *drained = sock ? &sock->drained : &shared->requestsDrained;
+
+    while (true) {
+        for (int i = 0; i < shared->numreceived; i++) {
+            auto *packet = &shared->received[i];
+            if (packet->length < 0 || shared->receivedFor[i] != sock)
+                continue;
+
+            const auto length = std::min(packet->length, len);
+            Q_memcpy(buf, packet->data, length);
+            *addr = packet->addr;
+            packet->length = -1;
+            return length;
+        }
+
+        if (*drained != shared->drains)
+            break;
+        Datagram_Drain(shared, landriver);
+    }
+
+    *drained = shared->drains;
+    return 0;
+}
+
+/*
+==================
+Datagram_Write
+
+Writes a datagram for a connection, queued until the next flush if it
+shares the listening socket
+==================
+*/
+static auto Datagram_Write(qsocket_t *sock, byte *data, int len, struct qsockaddr *addr) -> int {
+    if (!sock->shared)
+        return sfunc.Write(sock->socket, data, len, addr);
+
+    auto *shared = Datagram_SharedSocket(sock->landriver);
+    if (!shared)
+        return -1;
+
+    auto *packet = &shared->sending[shared->numsending++];
+    packet->addr = *addr;
+    packet->length = len;
+    Q_memcpy(packet->data, data, len);
+
+    if (shared->numsending == NET_BATCH)
+        Datagram_FlushShared(shared, sock->landriver);
+    return len;
+}
+
+void Datagram_Flush() {
+    for (int i = 0; i < net_numlandrivers; i++) {
+        if (!net_landrivers[i].initialized)
+            continue;
+
+        auto *shared = Datagram_SharedSocket(i);
+        if (shared)
+            Datagram_FlushShared(shared, i);
+    }
+}
+
+// only the listening sockets that are read in batches. Connections that
+// have sockets of their own (net_sharesocket 0) are left for the frame to
+// poll, there is nowhere to read them ahead into.
+void Datagram_WaitHandles(std::vector<int> &handles) {
+    for (int i = 0; i < net_numlandrivers; i++) {
+        if (!net_landrivers[i].initialized)
+            continue;
+
+        const auto *shared = Datagram_SharedSocket(i);
+        if (shared)
+            handles.push_back(shared->socket);
+    }
+}
+
+void Datagram_ReadAhead() {
+    for (int i = 0; i < net_numlandrivers; i++) {
+        if (!net_landrivers[i].initialized)
+            continue;
+
+        auto *shared = Datagram_SharedSocket(i);
+        if (shared)
+            Datagram_Drain(shared, i);
+    }
+}
+
+
+/*
+===============================================================================
+
+WINDOWED RELIABLE MESSAGES
+
+===============================================================================
+*/
+
+static auto Datagram_WriteFragment(qsocket_t *sock, netfragment_t *frag) -> int {
+    const auto packetLen = NET_HEADERSIZE + frag->length;
+
+    packetBuffer.length = BigLong(packetLen | NETFLAG_DATA | (frag->eom ? NETFLAG_EOM : 0));
+    packetBuffer.sequence = BigLong(frag->sequence);
+    Q_memcpy(packetBuffer.data, frag->data, frag->length);
+
+    frag->sendTime = net_time;
+    if (Datagram_Write(sock, (byte *) &packetBuffer, packetLen, &sock->addr) == -1)
+        return -1;
+
+    sock->lastSendTime = net_time;
+    return 1;
+}
+
+/*
+==================
+Datagram_FillWindow
+
+Cuts as much of the waiting message into fragments and sends them as the
+window has room for. Another message can be queued once all of this one
+is in flight.
+==================
+*/
+static auto Datagram_FillWindow(qsocket_t *sock) -> int {
+    while (sock->sendMessageLength > 0 && static_cast<int>(sock->sendSequence - sock->ackSequence) < sock->window) {
+        auto *frag = &sock->sendFragments[sock->sendSequence % NET_WINDOW];
+
+        frag->sequence = sock->sendSequence++;
+        frag->used = true;
+        frag->resent = false;
+        frag->length = std::min(sock->sendMessageLength, MAX_DATAGRAM);
+        frag->eom = frag->length == sock->sendMessageLength;
+        Q_memcpy(frag->data, sock->sendMessage, frag->length);
+
+        sock->sendMessageLength -= frag->length;
+        memmove(sock->sendMessage, sock->sendMessage + frag->length, sock->sendMessageLength);
+
+        if (Datagram_WriteFragment(sock, frag) == -1)
+            return -1;
+        packetsSent++;
+    }
+
+    sock->canSend = sock->sendMessageLength == 0;
+    return 1;
+}
+
+/*
+==================
+Datagram_ResendWindow
+
+Resends the fragments that have gone unacked for longer than the
+retransmit timeout, and backs the timeout off
+==================
+*/
+static void Datagram_ResendWindow(qsocket_t *sock) {
+    qboolean resent = false;
+
+    for (auto sequence = sock->ackSequence; sequence != sock->sendSequence; sequence++) {
+        auto *frag = &sock->sendFragments[sequence % NET_WINDOW];
+        if (!frag->used || net_time - frag->sendTime <= sock->rto)
+            continue;
+
+        frag->resent = true;
+        if (Datagram_WriteFragment(sock, frag) == -1)
+            return;
+        packetsReSent++;
+        resent = true;
+    }
+
+    if (resent)
+        sock->rto = std::min(sock->rto * 2, NET_MAXRTO);
+}
+
+/*
+==================
+Datagram_AckWindow
+
+Everything before sequence has arrived, and so has each fragment after it
+with a bit set in mask
+==================
+*/
+static void Datagram_AckWindow(qsocket_t *sock, unsigned int sequence, unsigned int mask) {
+    if (static_cast<int>(sequence - sock->ackSequence) < 0 || static_cast<int>(sequence - sock->sendSequence) > 0) {
+        Con_DPrintf("Stale ACK received\n");
+        return;
+    }
+
+    for (auto s = sock->ackSequence; s != sock->sendSequence; s++) {
+        auto *frag = &sock->sendFragments[s % NET_WINDOW];
+        const auto after = static_cast<int>(s - sequence);
+        if (!frag->used || (after >= 0 && (after == 0 || after > 32 || !(mask & (1U << (after - 1))))))
+            continue;
+
+        frag->used = false;
+        if (frag->resent)
+            continue;
+
+        // RFC 6298
+        const auto rtt = net_time - frag->sendTime;
+        if (sock->srtt == 0) {
+            sock->srtt = rtt;
+            sock->rttvar = rtt / 2;
+        } else {
+            sock->rttvar = 0.75 * sock->rttvar + 0.25 * std::fabs(sock->srtt - rtt);
+            sock->srtt = 0.875 * sock->srtt + 0.125 * rtt;
+        }
+        sock->rto = std::clamp(sock->srtt + 4 * sock->rttvar, NET_MINRTO, NET_MAXRTO);
+    }
+
+    while (sock->ackSequence != sock->sendSequence && !sock->sendFragments[sock->ackSequence % NET_WINDOW].used)
+        sock->ackSequence++;
+}
+
+/*
+==================
+Datagram_SendWindowAck
+
+Acks everything up to the first fragment still missing, counting ones
+that are waiting to be reassembled, and the ones after it in the mask.
+Sent after Datagram_ReassembleWindow, so the fragment that just came in
+order is covered.
+==================
+*/
+static void Datagram_SendWindowAck(qsocket_t *sock, struct qsockaddr *addr) {
+    auto missing = sock->receiveSequence;
+    for (int i = 0; i < sock->window; i++, missing++) {
+        const auto *frag = &sock->receiveFragments[missing % NET_WINDOW];
+        if (!frag->used || frag->sequence != missing)
+            break;
+    }
+
+    unsigned int mask = 0;
+    for (int i = 0; i < 32 && static_cast<int>(missing + 1 + i - sock->receiveSequence) < sock->window; i++) {
+        const auto sequence = missing + 1 + i;
+        const auto *frag = &sock->receiveFragments[sequence % NET_WINDOW];
+        if (frag->used && frag->sequence == sequence)
+            mask |= 1U << i;
+    }
+
+    packetBuffer.length = BigLong((NET_HEADERSIZE + 4) | NETFLAG_ACK);
+    packetBuffer.sequence = BigLong(missing);
+    *((unsigned int *) packetBuffer.data) = BigLong(mask);
+    Datagram_Write(sock, (byte *) &packetBuffer, NET_HEADERSIZE + 4, addr);
+}
+
+/*
+==================
+Datagram_ReassembleWindow
+
+Takes the fragments that are next in order, and returns true with the
+message in net_message if that completes one
+==================
+*/
+static auto Datagram_ReassembleWindow(qsocket_t *sock) -> qboolean {
+    while (true) {
+        auto *frag = &sock->receiveFragments[sock->receiveSequence % NET_WINDOW];
+        if (!frag->used || frag->sequence != sock->receiveSequence)
+            return false;
+
+        frag->used = false;
+        sock->receiveSequence++;
+
+        if (frag->eom) {
+            SZ_Clear(&net_message);
+            SZ_Write(&net_message, sock->receiveMessage, sock->receiveMessageLength);
+            SZ_Write(&net_message, frag->data, frag->length);
+            sock->receiveMessageLength = 0;
+            return true;
+        }
+
+        Q_memcpy(sock->receiveMessage + sock->receiveMessageLength, frag->data, frag->length);
+        sock->receiveMessageLength += frag->length;
+    }
+}
+
+//=============================================================================
+
 auto Datagram_SendMessage(qsocket_t *sock, sizebuf_t *data) -> int {
     unsigned int packetLen = 0;
     unsigned int dataLen = 0;
@@ -188,6 +614,9 @@ auto Datagram_SendMessage(qsocket_t *sock, sizebuf_t *data) -> int {
     Q_memcpy(sock->sendMessage, data->data, data->cursize);
     sock->sendMessageLength = data->cursize;
 
+    if (sock->window > 1)
+        return Datagram_FillWindow(sock);
+
     if (data->cursize <= MAX_DATAGRAM) {
         dataLen = data->cursize;
         eom = NETFLAG_EOM;
@@ -203,7 +632,7 @@ auto Datagram_SendMessage(qsocket_t *sock, sizebuf_t *data) -> int {
 
     sock->canSend = false;
 
-    if (sfunc.Write(sock->socket, (byte *) &packetBuffer, packetLen, &sock->addr) == -1)
+    if (Datagram_Write(sock, (byte *) &packetBuffer, packetLen, &sock->addr) == -1)
         return -1;
 
     sock->lastSendTime = net_time;
@@ -232,7 +661,7 @@ auto SendMessageNext(qsocket_t *sock) -> int {
 
     sock->sendNext = false;
 
-    if (sfunc.Write(sock->socket, (byte *) &packetBuffer, packetLen, &sock->addr) == -1)
+    if (Datagram_Write(sock, (byte *) &packetBuffer, packetLen, &sock->addr) == -1)
         return -1;
 
     sock->lastSendTime = net_time;
@@ -261,7 +690,7 @@ auto ReSendMessage(qsocket_t *sock) -> int {
 
     sock->sendNext = false;
 
-    if (sfunc.Write(sock->socket, (byte *) &packetBuffer, packetLen, &sock->addr) == -1)
+    if (Datagram_Write(sock, (byte *) &packetBuffer, packetLen, &sock->addr) == -1)
         return -1;
 
     sock->lastSendTime = net_time;
@@ -271,7 +700,9 @@ auto ReSendMessage(qsocket_t *sock) -> int {
 
 
 auto Datagram_CanSendMessage(qsocket_t *sock) -> qboolean {
-    if (sock->sendNext)
+    if (sock->window > 1)
+        Datagram_FillWindow(sock);
+    else if (sock->sendNext)
         SendMessageNext(sock);
 
     return sock->canSend;
@@ -300,7 +731,7 @@ auto Datagram_SendUnreliableMessage(qsocket_t *sock, sizebuf_t *data) -> int {
     packetBuffer.sequence = BigLong(sock->unreliableSendSequence++);
     Q_memcpy(packetBuffer.data, data->data, data->cursize);
 
-    if (sfunc.Write(sock->socket, (byte *) &packetBuffer, packetLen, &sock->addr) == -1)
+    if (Datagram_Write(sock, (byte *) &packetBuffer, packetLen, &sock->addr) == -1)
         return -1;
 
     packetsSent++;
@@ -316,12 +747,21 @@ auto Datagram_GetMessage(qsocket_t *sock) -> int {
     unsigned int sequence = 0;
     unsigned int count = 0;
 
-    if (!sock->canSend)
+    if (sock->window > 1) {
+        Datagram_ResendWindow(sock);
+
+        // a message may already be waiting from fragments that came early
+        if (Datagram_ReassembleWindow(sock))
+            return 1;
+    } else if (!sock->canSend)
         if ((net_time - sock->lastSendTime) > 1.0)
             ReSendMessage(sock);
 
     while (true) {
-        length = sfunc.Read(sock->socket, (byte *) &packetBuffer, NET_DATAGRAMSIZE, &readaddr);
+        if (sock->shared)
+            length = Datagram_ReadShared(sock->landriver, sock, (byte *) &packetBuffer, NET_DATAGRAMSIZE, &readaddr);
+        else
+            length = sfunc.Read(sock->socket, (byte *) &packetBuffer, NET_DATAGRAMSIZE, &readaddr);
 
 //	if ((rand() & 255) > 220)
 //		continue;
@@ -381,6 +821,11 @@ auto Datagram_GetMessage(qsocket_t *sock) -> int {
         }
 
         if (flags & NETFLAG_ACK) {
+            if (sock->window > 1) {
+                const auto mask = length >= NET_HEADERSIZE + 4 ? BigLong(*((unsigned int *) packetBuffer.data)) : 0;
+                Datagram_AckWindow(sock, sequence, mask);
+                continue;
+            }
             if (sequence != (sock->sendSequence - 1)) {
                 Con_DPrintf("Stale ACK received\n");
                 continue;
@@ -404,10 +849,36 @@ auto Datagram_GetMessage(qsocket_t *sock) -> int {
             continue;
         }
 
+        if ((flags & NETFLAG_DATA) && sock->window > 1) {
+            length -= NET_HEADERSIZE;
+            if (length > MAX_DATAGRAM) {
+                shortPacketCount++;
+                continue;
+            }
+
+            const auto ahead = static_cast<int>(sequence - sock->receiveSequence);
+            auto *frag = &sock->receiveFragments[sequence % NET_WINDOW];
+            if (ahead < 0 || (frag->used && frag->sequence == sequence))
+                receivedDuplicateCount++;
+            else if (ahead < sock->window) {
+                frag->sequence = sequence;
+                frag->used = true;
+                frag->eom = (flags & NETFLAG_EOM) != 0;
+                frag->length = length;
+                Q_memcpy(frag->data, packetBuffer.data, length);
+            }
+
+            ret = Datagram_ReassembleWindow(sock);
+            Datagram_SendWindowAck(sock, &readaddr);
+            if (ret)
+                break;
+            continue;
+        }
+
         if (flags & NETFLAG_DATA) {
             packetBuffer.length = BigLong(NET_HEADERSIZE | NETFLAG_ACK);
             packetBuffer.sequence = BigLong(sequence);
-            sfunc.Write(sock->socket, (byte *) &packetBuffer, NET_HEADERSIZE, &readaddr);
+            Datagram_Write(sock, (byte *) &packetBuffer, NET_HEADERSIZE, &readaddr);
 
             if (sequence != sock->receiveSequence) {
                 receivedDuplicateCount++;
@@ -433,7 +904,9 @@ auto Datagram_GetMessage(qsocket_t *sock) -> int {
         }
     }
 
-    if (sock->sendNext)
+    if (sock->window > 1)
+        Datagram_FillWindow(sock);
+    else if (sock->sendNext)
         SendMessageNext(sock);
 
     return ret;
@@ -444,6 +917,8 @@ void PrintStats(qsocket_t *s) {
     Con_Printf("canSend = %4u   \n", s->canSend);
     Con_Printf("sendSeq = %4u   ", s->sendSequence);
     Con_Printf("recvSeq = %4u   \n", s->receiveSequence);
+    Con_Printf("window  = %4i   ", s->window);
+    Con_Printf("rto     = %4.0f ms\n", s->rto * 1000);
     Con_Printf("\n");
 }
 
@@ -725,6 +1200,11 @@ auto Datagram_Init() -> int {
 
     myDriverLevel = net_driverlevel;
     Cmd_AddCommand("net_stats", NET_Stats_f);
+    Cvar_RegisterVariable(&net_sharesocket);
+    // a dedicated server sleeps between tics, and only its listening socket
+    // wakes it up to be read ahead, so its clients go through that one
+    if (cls.state == ca_dedicated)
+        Cvar_SetValue("net_sharesocket", 1);
 
     if (COM_CheckParm("-nolan"))
         return -1;
@@ -763,7 +1243,26 @@ void Datagram_Shutdown() {
 
 
 void Datagram_Close(qsocket_t *sock) {
-    sfunc.CloseSocket(sock->socket);
+    if (!sock->shared) {
+        sfunc.CloseSocket(sock->socket);
+        return;
+    }
+
+    // the listening socket stays open for everyone else
+    auto *shared = Datagram_SharedSocket(sock->landriver);
+    if (!shared)
+        return;
+
+    Datagram_FlushShared(shared, sock->landriver);
+
+    const auto it = shared->connections.find(Datagram_AddrKey(&sock->addr));
+    if (it != shared->connections.end() && it->second == sock)
+        shared->connections.erase(it);
+
+    for (int i = 0; i < shared->numreceived; i++) {
+        if (shared->receivedFor[i] == sock)
+            shared->received[i].length = -1;
+    }
 }
 
 
@@ -788,13 +1287,19 @@ static auto _Datagram_CheckNewConnections() -> qsocket_t * {
     int control = 0;
     int ret = 0;
 
-    acceptsock = dfunc.CheckNewConnections();
-    if (acceptsock == -1)
-        return nullptr;
-
-    SZ_Clear(&net_message);
+    auto *shared = Datagram_SharedSocket(net_landriverlevel);
+    if (shared) {
+        acceptsock = shared->socket;
+        SZ_Clear(&net_message);
+        len = Datagram_ReadShared(net_landriverlevel, nullptr, net_message.data, net_message.maxsize, &clientaddr);
+    } else {
+        acceptsock = dfunc.CheckNewConnections();
+        if (acceptsock == -1)
+            return nullptr;
 
-    len = dfunc.Read(acceptsock, net_message.data, net_message.maxsize, &clientaddr);
+        SZ_Clear(&net_message);
+        len = dfunc.Read(acceptsock, net_message.data, net_message.maxsize, &clientaddr);
+    }
     if (len < sizeof(int))
         return nullptr;
     net_message.cursize = len;
@@ -922,6 +1427,13 @@ static auto _Datagram_CheckNewConnections() -> qsocket_t * {
         return nullptr;
     }
 
+    // newer clients follow with the highest game protocol they understand,
+    // and how many reliable fragments they can take in flight
+    int protocol = MSG_ReadByte();
+    if (protocol < PROTOCOL_VERSION)
+        protocol = PROTOCOL_VERSION;
+    const auto window = std::clamp(MSG_ReadByte(), 1, NET_WINDOW);
+
 #ifdef BAN_TEST
     // check for a ban
     if (clientaddr.sa_family == AF_INET) {
@@ -956,6 +1468,8 @@ static auto _Datagram_CheckNewConnections() -> qsocket_t * {
                 MSG_WriteByte(&net_message, CCREP_ACCEPT);
                 dfunc.GetSocketAddr(s->socket, &newaddr);
                 MSG_WriteLong(&net_message, dfunc.GetSocketPort(&newaddr));
+                if (s->window > 1)
+                    MSG_WriteByte(&net_message, s->window);
                 *((int *) net_message.data) = BigLong(NETFLAG_CTL | (net_message.cursize & NETFLAG_LENGTH_MASK));
                 dfunc.Write(acceptsock, net_message.data, net_message.cursize, &clientaddr);
                 SZ_Clear(&net_message);
@@ -983,18 +1497,24 @@ static auto _Datagram_CheckNewConnections() -> qsocket_t * {
         return nullptr;
     }
 
-    // allocate a network socket
-    newsock = dfunc.OpenSocket(0);
-    if (newsock == -1) {
-        NET_FreeQSocket(sock);
-        return nullptr;
-    }
+    if (shared && net_sharesocket.value) {
+        // talk to the client through the listening socket
+        newsock = acceptsock;
+        sock->shared = true;
+    } else {
+        // allocate a network socket
+        newsock = dfunc.OpenSocket(0);
+        if (newsock == -1) {
+            NET_FreeQSocket(sock);
+            return nullptr;
+        }
 
-    // connect to the client
-    if (dfunc.Connect(newsock, &clientaddr) == -1) {
-        dfunc.CloseSocket(newsock);
-        NET_FreeQSocket(sock);
-        return nullptr;
+        // connect to the client
+        if (dfunc.Connect(newsock, &clientaddr) == -1) {
+            dfunc.CloseSocket(newsock);
+            NET_FreeQSocket(sock);
+            return nullptr;
+        }
     }
 
     // everything is allocated, just fill in the details
@@ -1002,6 +1522,10 @@ static auto _Datagram_CheckNewConnections() -> qsocket_t * {
     sock->landriver = net_landriverlevel;
     sock->addr = clientaddr;
     Q_strcpy(sock->address, dfunc.AddrToString(&clientaddr));
+    sock->protocol = protocol;
+    sock->window = window;
+    if (sock->shared)
+        shared->connections[Datagram_AddrKey(&sock->addr)] = sock;
 
     // send him back the info about the server connection he has been allocated
     SZ_Clear(&net_message);
@@ -1010,6 +1534,8 @@ static auto _Datagram_CheckNewConnections() -> qsocket_t * {
     MSG_WriteByte(&net_message, CCREP_ACCEPT);
     dfunc.GetSocketAddr(newsock, &newaddr);
     MSG_WriteLong(&net_message, dfunc.GetSocketPort(&newaddr));
+    if (window > 1)
+        MSG_WriteByte(&net_message, window);
 //	MSG_WriteString(&net_message, dfunc.AddrToString(&newaddr));
     *((int *) net_message.data) = BigLong(NETFLAG_CTL | (net_message.cursize & NETFLAG_LENGTH_MASK));
     dfunc.Write(acceptsock, net_message.data, net_message.cursize, &clientaddr);
@@ -1169,6 +1695,8 @@ static auto _Datagram_Connect(std::string_view host) -> qsocket_t * {
         MSG_WriteByte(&net_message, CCREQ_CONNECT);
         MSG_WriteString(&net_message, "QUAKE");
         MSG_WriteByte(&net_message, NET_PROTOCOL_VERSION);
+        MSG_WriteByte(&net_message, PROTOCOL_DELTA);
+        MSG_WriteByte(&net_message, NET_WINDOW);
         *((int *) net_message.data) = BigLong(NETFLAG_CTL | (net_message.cursize & NETFLAG_LENGTH_MASK));
         dfunc.Write(newsock, net_message.data, net_message.cursize, &sendaddr);
         SZ_Clear(&net_message);
@@ -1244,6 +1772,8 @@ static auto _Datagram_Connect(std::string_view host) -> qsocket_t * {
     if (ret == CCREP_ACCEPT) {
         memcpy(&sock->addr, &sendaddr, sizeof(struct qsockaddr));
         dfunc.SetSocketPort(&sock->addr, MSG_ReadLong());
+        // older servers don't send a window, and stay with stop and wait
+        sock->window = std::clamp(MSG_ReadByte(), 1, NET_WINDOW);
     } else {
         const auto reason = "Bad Response";
         Con_Printf("%s\n", reason);
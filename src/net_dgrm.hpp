@@ -43,3 +43,9 @@ qboolean Datagram_CanSendUnreliableMessage(qsocket_t *sock);
 void Datagram_Close(qsocket_t *sock);
 
 void Datagram_Shutdown(void);
+
+void Datagram_Flush(void);
+
+void Datagram_WaitHandles(std::vector<int> &handles);
+
+void Datagram_ReadAhead(void);
@@ -86,6 +86,7 @@ auto Loop_Connect(std::string_view host) -> qsocket_t * {
     loop_server->receiveMessageLength = 0;
     loop_server->sendMessageLength = 0;
     loop_server->canSend = true;
+    loop_server->protocol = PROTOCOL_DELTA;
 
     loop_client->driverdata = (void *) loop_server;
     loop_server->driverdata = (void *) loop_client;
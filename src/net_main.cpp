@@ -145,6 +145,17 @@ auto NET_NewQSocket() -> qsocket_t * {
     sock->receiveSequence = 0;
     sock->unreliableReceiveSequence = 0;
     sock->receiveMessageLength = 0;
+    sock->protocol = PROTOCOL_VERSION;
+    sock->window = 1;
+    sock->rto = NET_MAXRTO;
+    sock->srtt = 0;
+    sock->rttvar = 0;
+    for (int i = 0; i < NET_WINDOW; i++) {
+        sock->sendFragments[i].used = false;
+        sock->receiveFragments[i].used = false;
+    }
+    sock->shared = false;
+    sock->drained = 0;
 
     return sock;
 }
@@ -660,6 +671,37 @@ auto NET_CanSendMessage(qsocket_t *sock) -> qboolean {
 }
 
 
+/*
+==================
+NET_Flush
+==================
+*/
+void NET_Flush() {
+    for (net_driverlevel = 0; net_driverlevel < net_numdrivers; net_driverlevel++) {
+        if (net_drivers[net_driverlevel].initialized && dfunc.Flush)
+            dfunc.Flush();
+    }
+}
+
+
+void NET_WaitHandles(std::vector<int> &handles) {
+    handles.clear();
+    for (net_driverlevel = 0; net_driverlevel < net_numdrivers; net_driverlevel++) {
+        if (net_drivers[net_driverlevel].initialized && dfunc.WaitHandles)
+            dfunc.WaitHandles(handles);
+    }
+}
+
+
+void NET_ReadAhead() {
+    SetNetTime();
+    for (net_driverlevel = 0; net_driverlevel < net_numdrivers; net_driverlevel++) {
+        if (net_drivers[net_driverlevel].initialized && dfunc.ReadAhead)
+            dfunc.ReadAhead();
+    }
+}
+
+
 auto NET_SendToAll(sizebuf_t *data, int blocktime) -> int {
     double start = NAN;
     int i = 0;
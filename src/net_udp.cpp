@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <sys/ioctl.h>
 #include <cerrno>
 #include <unistd.h>
+#include <algorithm>
 
 #ifdef __sun__
 #include <sys/filio.h>
@@ -131,10 +132,8 @@ auto UDP_OpenSocket(int port) -> int {
     if ((newsocket = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1)
         return -1;
 
-#if 0
-    if (ioctl (newsocket, FIONBIO, (char *)&_true) == -1)
+    if (ioctl(newsocket, FIONBIO, (char *) &_true) == -1)
         goto ErrorReturn;
-#endif
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
     address.sin_port = htons(port);
@@ -248,6 +247,109 @@ auto UDP_Read(int socket, byte *buf, int len, struct qsockaddr *addr) -> int {
 
 //=============================================================================
 
+auto UDP_ListenSocket() -> int {
+    return net_acceptsocket;
+}
+
+//=============================================================================
+
+/*
+============
+UDP_ReadBatch
+
+Reads as many of the datagrams waiting on the socket as fit, without
+blocking, and returns how many
+============
+*/
+auto UDP_ReadBatch(int socket, netpacket_t *packets, int count) -> int {
+    count = std::min(count, NET_BATCH);
+
+#ifdef __linux__
+    struct mmsghdr msgs[NET_BATCH];
+    struct iovec iov[NET_BATCH];
+
+    for (int i = 0; i < count; i++) {
+        iov[i] = {packets[i].data, sizeof(packets[i].data)};
+        msgs[i] = {};
+        msgs[i].msg_hdr.msg_name = &packets[i].addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct qsockaddr);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const auto ret = recvmmsg(socket, msgs, count, MSG_DONTWAIT, nullptr);
+    if (ret == -1)
+        return errno == EWOULDBLOCK || errno == ECONNREFUSED ? 0 : -1;
+
+    for (int i = 0; i < ret; i++)
+        packets[i].length = static_cast<int>(msgs[i].msg_len);
+    return ret;
+#else
+    for (int i = 0; i < count; i++) {
+        socklen_t addrlen = sizeof(struct qsockaddr);
+
+        const auto ret = recvfrom(socket, packets[i].data, sizeof(packets[i].data), MSG_DONTWAIT,
+                                  (struct sockaddr *) &packets[i].addr, &addrlen);
+        if (ret == -1)
+            return errno == EWOULDBLOCK || errno == ECONNREFUSED ? i : -1;
+        packets[i].length = static_cast<int>(ret);
+    }
+    return count;
+#endif
+}
+
+//=============================================================================
+
+/*
+============
+UDP_WriteBatch
+
+A datagram that can't be sent is dropped, as UDP_Write would, rather than
+holding up the ones after it
+============
+*/
+auto UDP_WriteBatch(int socket, netpacket_t *packets, int count) -> int {
+    int sent = 0;
+
+#ifdef __linux__
+    struct mmsghdr msgs[NET_BATCH];
+    struct iovec iov[NET_BATCH];
+
+    while (sent < count) {
+        const auto batch = std::min(count - sent, NET_BATCH);
+
+        for (int i = 0; i < batch; i++) {
+            auto *packet = &packets[sent + i];
+            iov[i] = {packet->data, static_cast<size_t>(packet->length)};
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_name = &packet->addr;
+            msgs[i].msg_hdr.msg_namelen = sizeof(struct qsockaddr);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        const auto ret = sendmmsg(socket, msgs, batch, 0);
+        if (ret == -1) {
+            if (errno != EWOULDBLOCK && errno != ECONNREFUSED)
+                return -1;
+            sent++;
+            continue;
+        }
+        sent += ret;
+    }
+#else
+    for (; sent < count; sent++) {
+        if (UDP_Write(socket, packets[sent].data, packets[sent].length, &packets[sent].addr) == -1
+            && errno != ECONNREFUSED)
+            return -1;
+    }
+#endif
+
+    return sent;
+}
+
+//=============================================================================
+
 auto UDP_MakeSocketBroadcastCapable(int socket) -> int {
     int i = 1;
 
@@ -37,6 +37,12 @@ int UDP_Read(int socket, byte *buf, int len, struct qsockaddr *addr);
 
 int UDP_Write(int socket, byte *buf, int len, struct qsockaddr *addr);
 
+int UDP_ListenSocket(void);
+
+int UDP_ReadBatch(int socket, netpacket_t *packets, int count);
+
+int UDP_WriteBatch(int socket, netpacket_t *packets, int count);
+
 int UDP_Broadcast(int socket, byte *buf, int len);
 
 char *UDP_AddrToString(struct qsockaddr *addr);
@@ -18,6 +18,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include "util.hpp"
@@ -211,7 +212,7 @@ void PF_setmodel() {
             break;
 
     if (!*check)
-        PR_RunError("no precache: %s\n", m.second.c_str());
+        PR_RunError("no precache: %s\n", m.second.data());
 
     e->v.model = m.first;
     e->v.modelindex = i; //SV_ModelIndex (m);
@@ -570,7 +571,7 @@ byte checkpvs[MAX_MAP_LEAFS / 8];
 
 auto PF_newcheckclient(int check) -> int {
     int i = 0;
-    byte *pvs = nullptr;
+    const byte *pvs = nullptr;
     edict_t *ent = nullptr;
     mleaf_t *leaf = nullptr;
     vec3 org;
@@ -610,7 +611,7 @@ auto PF_newcheckclient(int check) -> int {
 // get the PVS for the entity
     org = ent->v.origin + ent->v.view_ofs;
     leaf = Mod_PointInLeaf(org, sv.worldmodel);
-    pvs = Mod_LeafPVS(leaf, sv.worldmodel);
+    pvs = SV_LeafPVS(leaf);
     memcpy(checkpvs, pvs, (sv.worldmodel->numleafs + 7) >> 3);
 
     return i;
@@ -746,18 +747,38 @@ void PF_findradius() {
     const auto org = G_VECTOR(OFS_PARM0);
     const auto rad = G_FLOAT(OFS_PARM1);
 
-    auto *ent = NEXT_EDICT(sv.edicts);
-    for (int i = 1; i < sv.num_edicts; i++, ent = NEXT_EDICT(ent)) {
-        if (ent->free)
+    ED_SyncHot();
+
+    // everything whose centre could be in range is linked with a box
+    // touching the sphere's, or is a stray. NaNs match everything.
+    static std::vector<int> nums;
+    nums.clear();
+    if (std::isnan(rad + org[0] + org[1] + org[2])) {
+        for (int i = 1; i < sv.num_edicts; i++)
+            nums.push_back(i);
+    } else {
+        const vec3 reach = {rad, rad, rad};
+        SV_AreaEdicts(org - reach, org + reach, nums);
+        nums.insert(nums.end(), ed_strays.begin(), ed_strays.end());
+        std::sort(nums.begin(), nums.end());
+        nums.erase(std::unique(nums.begin(), nums.end()), nums.end());
+    }
+
+    // in edict order, so the chain comes out as a full scan would make it
+    for (const auto i: nums) {
+        if (i == 0)
+            continue;
+        if (ed_hot.free[i])
             continue;
-        if (ent->v.solid == SOLID_NOT)
+        if (ed_hot.solid[i] == SOLID_NOT)
             continue;
 
-        const auto eorg = org - (ent->v.origin + (ent->v.mins + ent->v.maxs) * 0.5F);
+        const auto eorg = org - ed_hot.center[i];
 
         if (glm::length(eorg) > rad)
             continue;
 
+        auto *ent = EDICT_NUM(i);
         ent->v.chain = EDICT_TO_PROG(chain);
         chain = ent;
     }
@@ -775,13 +796,6 @@ void PF_dprint() {
     Con_DPrintf("%s", PF_VarString(0).c_str());
 }
 
-inline auto PF_FindOrAddString(std::string &str) {
-    if (auto existing_offset = getOffsetByString(str)) {
-        return existing_offset;
-    }
-    return newString(str);
-}
-
 void PF_ftos() {
     float v = G_FLOAT(OFS_PARM0);
     std::string temp;
@@ -791,7 +805,7 @@ void PF_ftos() {
     } else
         temp = fmt::sprintf("%5.1f", v);
 
-    G_INT(OFS_RETURN) = PF_FindOrAddString(temp);
+    G_INT(OFS_RETURN) = newString(std::move(temp));
 }
 
 void PF_fabs() {
@@ -801,7 +815,7 @@ void PF_fabs() {
 void PF_vtos() {
     std::string temp = fmt::sprintf("'%5.1f %5.1f %5.1f'", G_VECTOR(OFS_PARM0)[0], G_VECTOR(OFS_PARM0)[1],
                                     G_VECTOR(OFS_PARM0)[2]);
-    G_INT(OFS_RETURN) = PF_FindOrAddString(temp);
+    G_INT(OFS_RETURN) = newString(std::move(temp));
 }
 
 #ifdef QUAKE2
@@ -884,6 +898,12 @@ void PF_Find()
     if (s.empty())
         PR_RunError("PF_Find: bad search string");
 
+    const auto found = ED_FindIndexed(e, G_INT(OFS_PARM1), s);
+    if (found >= 0) {
+        RETURN_EDICT(EDICT_NUM(found));
+        return;
+    }
+
     for (e++; e < sv.num_edicts; e++) {
         edict_t *ed = EDICT_NUM(e);
         if (ed->free)
@@ -1044,6 +1064,7 @@ void PF_droptofloor() {
         SV_LinkEdict(ent, false);
         ent->v.flags = (int) ent->v.flags | FL_ONGROUND;
         ent->v.groundentity = EDICT_TO_PROG(trace.ent);
+        ED_CHANGED(ent);
         G_FLOAT(OFS_RETURN) = 1;
     }
 }
@@ -1124,7 +1145,6 @@ entity nextent(entity)
 */
 void PF_nextent() {
     int i = 0;
-    edict_t *ent = nullptr;
 
     i = G_EDICTNUM(OFS_PARM0);
     while (true) {
@@ -1133,9 +1153,9 @@ void PF_nextent() {
             RETURN_EDICT(sv.edicts);
             return;
         }
-        ent = EDICT_NUM(i);
-        if (!ent->free) {
-            RETURN_EDICT(ent);
+        ED_SyncHot(i);
+        if (!ed_hot.free[i]) {
+            RETURN_EDICT(EDICT_NUM(i));
             return;
         }
     }
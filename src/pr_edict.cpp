@@ -19,9 +19,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // sv_edict.c -- entity dictionary
 
-#include <string>
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <sstream>
+#include <string>
+#include <unordered_map>
 #include "util.hpp"
 
 dprograms_t *progs;
@@ -34,9 +39,9 @@ globalvars_t *pr_global_struct;
 float *pr_globals;            // same as pr_global_struct
 int pr_edict_size;    // in bytes
 
-std::map<unsigned, std::string> edictStrings;
+int pr_stringssize;
+int pr_maxstrings;
 std::vector<dfunction_t> edictFunctions;
-std::size_t staticStringCount{};
 
 unsigned short pr_crc;
 
@@ -58,16 +63,297 @@ cvar_t saved2 = {"saved2", "0", true};
 cvar_t saved3 = {"saved3", "0", true};
 cvar_t saved4 = {"saved4", "0", true};
 
-#define    MAX_FIELD_LEN    64
-#define GEFV_CACHESIZE    2
+// name and offset lookups for the progs defs, rebuilt by PR_LoadProgs
+static std::unordered_map<std::string_view, ddef_t *> fieldIndex;
+static std::unordered_map<std::string_view, ddef_t *> globalIndex;
+static std::vector<ddef_t *> fieldsByOfs;
+static std::vector<ddef_t *> globalsByOfs;
+
+// optional fields the engine reads, -1 if the progs don't define them
+int eval_gravity;
+int eval_items2;
+int eval_ammo_shells1;
+int eval_ammo_nails1;
+int eval_ammo_lava_nails;
+int eval_ammo_rockets1;
+int eval_ammo_multi_rockets;
+int eval_ammo_cells1;
+int eval_ammo_plasma;
+
+edhot_t ed_hot;
+byte *ed_changed;
+std::vector<int> ed_strays;
+
+static std::vector<byte> ed_changedbytes;
+
+// find() on these fields looks the string up instead of scanning
+static const int ed_findfields[] = {
+        offsetof(entvars_t, classname) / 4,
+        offsetof(entvars_t, targetname) / 4,
+        offsetof(entvars_t, target) / 4,
+};
+#define    NUM_FIND_FIELDS    3
+
+// the non free edicts with each value, in edict order
+static std::unordered_map<std::string_view, std::vector<int>> ed_findindex[NUM_FIND_FIELDS];
+static std::vector<string_t> ed_findkeys[NUM_FIND_FIELDS];    // what each edict is indexed under
+
+static_assert(sizeof(edict_t) > 1 << ED_CHANGED_SHIFT, "edicts must not share a changed byte");
 
-using gefv_cache = struct {
-    ddef_t *pcache;
-    char field[MAX_FIELD_LEN];
+// free edicts in the order they were freed, so the front is always the one
+// that has waited longest. An edict freed again gets a new entry, and the
+// old one no longer matches its freetime.
+using edfree_t = struct {
+    int num;
+    float freetime;
 };
 
-static gefv_cache gefvCache[GEFV_CACHESIZE] = {{nullptr, ""},
-                                               {nullptr, ""}};
+static std::deque<edfree_t> ed_freequeue;
+
+// set for an edict when its hot fields have been brought up to date, or
+// its think comes due, until SV_Physics has looked at it. Indexed like
+// ed_changed, so the two can be scanned together.
+static std::vector<byte> ed_pending;
+
+// pending thinks, soonest at the front of the heap. Entries are pushed
+// whenever an edict's nextthink changes, and only count while it still
+// holds the same value.
+using edthink_t = struct {
+    float nextthink;
+    int num;
+};
+
+static std::vector<edthink_t> ed_thinks;
+
+static auto ED_ThinkLater(const edthink_t &a, const edthink_t &b) -> bool {
+    return a.nextthink > b.nextthink;
+}
+
+/*
+=================
+ED_ResetHot
+
+Called when sv.edicts is allocated. Everything starts out changed, and
+nothing is free yet.
+=================
+*/
+void ED_ResetHot() {
+    ed_freequeue.clear();
+    ed_thinks.clear();
+
+    const auto count = static_cast<std::size_t>(sv.max_edicts);
+
+    ed_hot.free.assign(count, true);
+    ed_hot.movetype.assign(count, 0);
+    ed_hot.solid.assign(count, 0);
+    ed_hot.flags.assign(count, 0);
+    ed_hot.nextthink.assign(count, 0);
+    ed_hot.visible.assign(count, false);
+    ed_hot.center.assign(count, vec3_origin);
+    ed_hot.numleafs.assign(count, 0);
+    ed_hot.leafnums.assign(count * MAX_ENT_LEAFS, 0);
+    ed_hot.strayslot.assign(count, -1);
+    ed_strays.clear();
+
+    for (int i = 0; i < NUM_FIND_FIELDS; i++) {
+        ed_findindex[i].clear();
+        ed_findkeys[i].assign(count, 0);
+    }
+
+    // padded so ED_SyncHot can read it a word at a time. Only the byte each
+    // edict starts in is ever marked, the ones between have to stay clear
+    // for the scans to skip them.
+    ed_changedbytes.assign(((count * pr_edict_size) >> ED_CHANGED_SHIFT) + 8, 0);
+    ed_changed = ed_changedbytes.data();
+    for (std::size_t i = 0; i < count; i++)
+        ed_changed[(i * pr_edict_size) >> ED_CHANGED_SHIFT] = 1;
+    ed_pending.assign(ed_changedbytes.size(), 0);
+}
+
+static void ED_SetStray(int num, bool stray) {
+    auto *slot = &ed_hot.strayslot[num];
+
+    if (stray && *slot < 0) {
+        *slot = static_cast<int>(ed_strays.size());
+        ed_strays.push_back(num);
+    } else if (!stray && *slot >= 0) {
+        ed_hot.strayslot[ed_strays.back()] = *slot;
+        ed_strays[*slot] = ed_strays.back();
+        ed_strays.pop_back();
+        *slot = -1;
+    }
+}
+
+static void ED_SetFindKey(int field, int num, string_t key) {
+    auto *current = &ed_findkeys[field][num];
+    if (*current == key)
+        return;
+
+    auto &index = ed_findindex[field];
+    if (*current) {
+        auto &nums = index[getStringByOffset(*current)];
+        nums.erase(std::lower_bound(nums.begin(), nums.end(), num));
+    }
+    if (key) {
+        auto &nums = index[getStringByOffset(key)];
+        nums.insert(std::lower_bound(nums.begin(), nums.end(), num), num);
+    }
+    *current = key;
+}
+
+/*
+=================
+ED_FindIndexed
+=================
+*/
+auto ED_FindIndexed(int start, int field, std::string_view s) -> int {
+    int i = 0;
+    for (; i < NUM_FIND_FIELDS; i++) {
+        if (ed_findfields[i] == field)
+            break;
+    }
+    if (i == NUM_FIND_FIELDS)
+        return -1;
+
+    ED_SyncHot();
+
+    const auto it = ed_findindex[i].find(s);
+    if (it == ed_findindex[i].end())
+        return 0;
+
+    const auto &nums = it->second;
+    const auto next = std::upper_bound(nums.begin(), nums.end(), start);
+    return next == nums.end() ? 0 : *next;
+}
+
+/*
+=================
+ED_SyncHot
+
+Copies the hot fields of edict num if it has been marked since the last
+time
+=================
+*/
+void ED_SyncHot(int num) {
+    const auto ofs = static_cast<std::size_t>(num) * pr_edict_size;
+    auto *changed = &ed_changed[ofs >> ED_CHANGED_SHIFT];
+    if (!*changed)
+        return;
+    *changed = 0;
+    ed_pending[ofs >> ED_CHANGED_SHIFT] = 1;
+
+    const auto *e = reinterpret_cast<const edict_t *>(reinterpret_cast<const byte *>(sv.edicts) + ofs);
+    if (e->v.nextthink != ed_hot.nextthink[num] && e->v.nextthink > 0) {
+        ed_thinks.push_back({e->v.nextthink, num});
+        std::push_heap(ed_thinks.begin(), ed_thinks.end(), ED_ThinkLater);
+    }
+
+    ed_hot.free[num] = e->free;
+    ed_hot.movetype[num] = e->v.movetype;
+    ed_hot.solid[num] = e->v.solid;
+    ed_hot.flags[num] = e->v.flags;
+    ed_hot.nextthink[num] = e->v.nextthink;
+    ed_hot.visible[num] = e->v.modelindex && stringExistsAtOffset(e->v.model);
+    ed_hot.center[num] = e->v.origin + (e->v.mins + e->v.maxs) * 0.5F;
+    ed_hot.numleafs[num] = e->num_leafs;
+    memcpy(&ed_hot.leafnums[num * MAX_ENT_LEAFS], e->leafnums, e->num_leafs * sizeof(short));
+
+    ED_SetStray(num, !e->free && e->v.solid != SOLID_NOT && !SV_AreaContains(e, ed_hot.center[num]));
+
+    for (int i = 0; i < NUM_FIND_FIELDS; i++) {
+        const auto key = *(const string_t *) &((const float *) &e->v)[ed_findfields[i]];
+        ED_SetFindKey(i, num, !e->free && stringExistsAtOffset(key) ? key : 0);
+    }
+}
+
+/*
+=================
+ED_SyncHot
+
+Brings every edict's hot fields up to date, skipping over the unchanged
+ones a word at a time
+=================
+*/
+void ED_SyncHot() {
+    const auto bytes = ((static_cast<std::size_t>(sv.num_edicts) * pr_edict_size) >> ED_CHANGED_SHIFT) + 1;
+
+    for (std::size_t k = 0; k < bytes; k += 8) {
+        std::uint64_t word = 0;
+        memcpy(&word, ed_changed + k, sizeof(word));
+        if (!word)
+            continue;
+
+        for (auto j = k; j < k + 8; j++) {
+            if (!ed_changed[j])
+                continue;
+            // the one edict starting in these bytes
+            const auto num = static_cast<int>(((j << ED_CHANGED_SHIFT) + pr_edict_size - 1) / pr_edict_size);
+            if ((static_cast<std::size_t>(num) * pr_edict_size) >> ED_CHANGED_SHIFT != j)
+                ed_changed[j] = 0;        // between two edicts, nothing reads it
+            else if (num < sv.num_edicts)
+                ED_SyncHot(num);
+        }
+    }
+}
+
+/*
+=================
+ED_WakeThinks
+
+Marks every edict whose think is due by deadline as pending
+=================
+*/
+void ED_WakeThinks(double deadline) {
+    while (!ed_thinks.empty() && ed_thinks.front().nextthink <= deadline) {
+        const auto think = ed_thinks.front();
+        std::pop_heap(ed_thinks.begin(), ed_thinks.end(), ED_ThinkLater);
+        ed_thinks.pop_back();
+
+        if (ed_hot.nextthink[think.num] == think.nextthink)
+            ed_pending[(static_cast<std::size_t>(think.num) * pr_edict_size) >> ED_CHANGED_SHIFT] = 1;
+    }
+}
+
+/*
+=================
+ED_NextPending
+
+The first edict from num on that is pending or has been marked changed,
+or sv.num_edicts if there are none. Its hot fields are brought up to date
+and its pending mark cleared, so the caller has to look at it now. Reads
+the marks as it goes, so edicts marked further on while the caller works
+through them are still found.
+=================
+*/
+auto ED_NextPending(int num) -> int {
+    const auto end = ((static_cast<std::size_t>(sv.num_edicts) * pr_edict_size) >> ED_CHANGED_SHIFT) + 1;
+    auto k = (static_cast<std::size_t>(num) * pr_edict_size) >> ED_CHANGED_SHIFT;
+
+    while (k < end) {
+        if (!(k & 7)) {
+            std::uint64_t changed = 0, pending = 0;
+            memcpy(&changed, ed_changed + k, sizeof(changed));
+            memcpy(&pending, ed_pending.data() + k, sizeof(pending));
+            if (!(changed | pending)) {
+                k += 8;
+                continue;
+            }
+        }
+
+        if (ed_changed[k] || ed_pending[k]) {
+            // the one edict starting in this byte
+            const auto found = static_cast<int>(((k << ED_CHANGED_SHIFT) + pr_edict_size - 1) / pr_edict_size);
+            if (found >= num && found < sv.num_edicts) {
+                ED_SyncHot(found);
+                ed_pending[k] = 0;
+                return found;
+            }
+        }
+        k++;
+    }
+
+    return sv.num_edicts;
+}
 
 /*
 =================
@@ -79,6 +365,7 @@ Sets everything to NULL
 void ED_ClearEdict(edict_t *e) {
     memset(&e->v, 0, progs->entityfields * 4);
     e->free = false;
+    ED_CHANGED(e);
 }
 
 /*
@@ -93,29 +380,60 @@ angles and bad trails.
 =================
 */
 auto ED_Alloc() -> edict_t * {
-    int i = 0;
     edict_t *e = nullptr;
 
-    for (i = svs.maxclients + 1; i < sv.num_edicts; i++) {
-        e = EDICT_NUM(i);
+    while (!ed_freequeue.empty()) {
+        const auto entry = ed_freequeue.front();
+        e = EDICT_NUM(entry.num);
+        if (!e->free || e->freetime != entry.freetime) {
+            ed_freequeue.pop_front();        // reused or freed again since
+            continue;
+        }
+
         // the first couple seconds of server time can involve a lot of
         // freeing and allocating, so relax the replacement policy
-        if (e->free && (e->freetime < 2 || sv.time - e->freetime > 0.5)) {
-            ED_ClearEdict(e);
-            return e;
-        }
+        if (!(e->freetime < 2 || sv.time - e->freetime > 0.5))
+            break;        // nothing behind it has waited longer
+
+        ed_freequeue.pop_front();
+        ED_ClearEdict(e);
+        return e;
     }
 
-    if (i == MAX_EDICTS)
+    if (sv.num_edicts == MAX_EDICTS)
         Sys_Error("ED_Alloc: no free edicts");
 
+    e = EDICT_NUM(sv.num_edicts);
     sv.num_edicts++;
-    e = EDICT_NUM(i);
     ED_ClearEdict(e);
 
     return e;
 }
 
+/*
+=================
+ED_QueueFree
+
+Puts a newly freed edict at the back of the free queue
+=================
+*/
+static void ED_QueueFree(edict_t *ed) {
+    const auto num = NUM_FOR_EDICT(ed);
+    if (num <= svs.maxclients)
+        return;        // client slots are never handed out
+
+    // throw away the stale entries now and then, in case something keeps
+    // removing the same edicts without anything being spawned
+    if (ed_freequeue.size() > static_cast<std::size_t>(sv.max_edicts) * 2) {
+        std::erase_if(ed_freequeue, [](const edfree_t &entry) {
+            const auto *e = EDICT_NUM(entry.num);
+            return !e->free || e->freetime != entry.freetime;
+        });
+    }
+
+    ed_freequeue.push_back({num, ed->freetime});
+}
+
 /*
 =================
 ED_Free
@@ -126,6 +444,7 @@ FIXME: walk all entities and NULL out references to this entity
 */
 void ED_Free(edict_t *ed) {
     SV_UnlinkEdict(ed);        // unlink from world bsp
+    SV_ForgetTouches(ed);
 
     ed->free = true;
     ed->v.model = 0;
@@ -140,6 +459,8 @@ void ED_Free(edict_t *ed) {
     ed->v.solid = 0;
 
     ed->freetime = sv.time;
+    ED_QueueFree(ed);
+    ED_CHANGED(ed);
 }
 
 //===========================================================================
@@ -150,15 +471,9 @@ ED_GlobalAtOfs
 ============
 */
 auto ED_GlobalAtOfs(int ofs) -> ddef_t * {
-    ddef_t *def = nullptr;
-    int i = 0;
-
-    for (i = 0; i < progs->numglobaldefs; i++) {
-        def = &pr_globaldefs[i];
-        if (def->ofs == ofs)
-            return def;
-    }
-    return nullptr;
+    if (ofs < 0 || static_cast<std::size_t>(ofs) >= globalsByOfs.size())
+        return nullptr;
+    return globalsByOfs[ofs];
 }
 
 /*
@@ -167,15 +482,9 @@ ED_FieldAtOfs
 ============
 */
 auto ED_FieldAtOfs(int ofs) -> ddef_t * {
-    ddef_t *def = nullptr;
-    int i = 0;
-
-    for (i = 0; i < progs->numfielddefs; i++) {
-        def = &pr_fielddefs[i];
-        if (def->ofs == ofs)
-            return def;
-    }
-    return nullptr;
+    if (ofs < 0 || static_cast<std::size_t>(ofs) >= fieldsByOfs.size())
+        return nullptr;
+    return fieldsByOfs[ofs];
 }
 
 /*
@@ -184,11 +493,8 @@ ED_FindField
 ============
 */
 auto ED_FindField(std::string_view name) -> ddef_t * {
-    for (auto i = 0; i < progs->numfielddefs; i++) {
-        auto *def = &pr_fielddefs[i];
-        if (getStringByOffset(def->s_name) == name)
-            return def;
-    }
+    if (const auto it = fieldIndex.find(name); it != fieldIndex.end())
+        return it->second;
     return nullptr;
 }
 
@@ -199,40 +505,72 @@ ED_FindGlobal
 ============
 */
 auto ED_FindGlobal(std::string_view name) -> ddef_t * {
-    for (auto i = 0; i < progs->numglobaldefs; i++) {
-        auto def = &pr_globaldefs[i];
-        if (getStringByOffset(def->s_name) == name)
-            return def;
-    }
+    if (const auto it = globalIndex.find(name); it != globalIndex.end())
+        return it->second;
     return nullptr;
 }
 
+/*
+============
+ED_FindFieldOffset
 
-auto GetEdictFieldValue(edict_t *ed, std::string_view field) -> eval_t * {
-    ddef_t *def = nullptr;
-    int i = 0;
-    static int rep = 0;
+Returns the field offset to pass to GetEdictFieldValue, or -1 if the
+progs don't define the field
+============
+*/
+auto ED_FindFieldOffset(std::string_view name) -> int {
+    const auto *def = ED_FindField(name);
+    return def ? def->ofs : -1;
+}
 
-    for (i = 0; i < GEFV_CACHESIZE; i++) {
-        if (!Q_strcmp(field, gefvCache[i].field)) {
-            def = gefvCache[i].pcache;
-            goto Done;
-        }
-    }
 
-    def = ED_FindField(field);
+auto GetEdictFieldValue(edict_t *ed, int fieldoffset) -> eval_t * {
+    if (fieldoffset < 0)
+        return nullptr;
 
-    if (field.length() < MAX_FIELD_LEN) {
-        gefvCache[rep].pcache = def;
-        strncpy(gefvCache[rep].field, field.data(), field.length());
-        rep ^= 1;
-    }
+    return (eval_t *) ((char *) &ed->v + fieldoffset * 4);
+}
 
-    Done:
-    if (!def)
-        return nullptr;
+auto GetEdictFieldValue(edict_t *ed, std::string_view field) -> eval_t * {
+    return GetEdictFieldValue(ed, ED_FindFieldOffset(field));
+}
+
+/*
+============
+PR_BuildDefIndices
+
+Hashes the field and global defs by name and offset, and resolves the
+optional fields the engine looks at, so none of that is scanned for later
+============
+*/
+static void PR_BuildDefIndices() {
+    auto build = [](ddef_t *defs, int numdefs, std::size_t numofs,
+                    std::unordered_map<std::string_view, ddef_t *> &byName, std::vector<ddef_t *> &byOfs) {
+        byName.clear();
+        byName.reserve(numdefs);
+        byOfs.assign(numofs, nullptr);
+
+        // the first def wins for both lookups, same as the old linear scans did
+        for (auto i = 0; i < numdefs; i++) {
+            auto *def = &defs[i];
+            byName.try_emplace(getStringByOffset(def->s_name), def);
+            if (def->ofs < byOfs.size() && !byOfs[def->ofs])
+                byOfs[def->ofs] = def;
+        }
+    };
 
-    return (eval_t *) ((char *) &ed->v + def->ofs * 4);
+    build(pr_fielddefs, progs->numfielddefs, progs->entityfields, fieldIndex, fieldsByOfs);
+    build(pr_globaldefs, progs->numglobaldefs, progs->numglobals, globalIndex, globalsByOfs);
+
+    eval_gravity = ED_FindFieldOffset("gravity");
+    eval_items2 = ED_FindFieldOffset("items2");
+    eval_ammo_shells1 = ED_FindFieldOffset("ammo_shells1");
+    eval_ammo_nails1 = ED_FindFieldOffset("ammo_nails1");
+    eval_ammo_lava_nails = ED_FindFieldOffset("ammo_lava_nails");
+    eval_ammo_rockets1 = ED_FindFieldOffset("ammo_rockets1");
+    eval_ammo_multi_rockets = ED_FindFieldOffset("ammo_multi_rockets");
+    eval_ammo_cells1 = ED_FindFieldOffset("ammo_cells1");
+    eval_ammo_plasma = ED_FindFieldOffset("ammo_plasma");
 }
 
 
@@ -743,9 +1081,12 @@ auto ED_ParseEdict(std::string_view data, edict_t *ent) -> std::string_view {
             Host_Error("ED_ParseEdict: parse error");
     }
 
-    if (!init)
+    if (!init) {
         ent->free = true;
+        ED_QueueFree(ent);
+    }
 
+    ED_CHANGED(ent);
     return data;
 }
 
@@ -838,11 +1179,6 @@ PR_LoadProgs
 void PR_LoadProgs() {
     int i = 0;
 
-// flush the non-C variable lookup cache
-    for (i = 0; i < GEFV_CACHESIZE; i++)
-        gefvCache[i].field[0] = 0;
-
-
     CRC_Init(&pr_crc);
 
     progs = (dprograms_t *) COM_LoadHunkFile("progs.dat");
@@ -864,7 +1200,7 @@ void PR_LoadProgs() {
         Sys_Error("progs.dat system vars have been modified, progdefs.h is out of date");
 
     pr_functions = (dfunction_t *) ((byte *) progs + progs->ofs_functions);
-    pr_strings = (char *) progs + progs->ofs_strings;
+    resetStringTable({(char *) progs + progs->ofs_strings, static_cast<std::size_t>(progs->numstrings)});
     pr_globaldefs = (ddef_t *) ((byte *) progs + progs->ofs_globaldefs);
     pr_fielddefs = (ddef_t *) ((byte *) progs + progs->ofs_fielddefs);
     pr_statements = (dstatement_t *) ((byte *) progs + progs->ofs_statements);
@@ -881,6 +1217,7 @@ void PR_LoadProgs() {
         pr_statements[i].b = LittleShort(pr_statements[i].b);
         pr_statements[i].c = LittleShort(pr_statements[i].c);
     }
+    edictFunctions.clear();
     edictFunctions.reserve(progs->numfunctions);
     for (i = 0; i < progs->numfunctions; i++) {
         edictFunctions.emplace_back(dfunction_t{
@@ -911,15 +1248,11 @@ void PR_LoadProgs() {
     for (i = 0; i < progs->numglobals; i++)
         ((int *) pr_globals)[i] = LittleLong(((int *) pr_globals)[i]);
 
-    std::string temp;
-    for (auto j = 1; j < progs->numstrings; j++) {
-        if (pr_strings[j] != '\0') {
-            temp += pr_strings[j];
-        } else {
-            edictStrings[j - temp.length()] = std::move(temp);
-            temp.clear();
-        }
-    }
+    PR_BuildDefIndices();
+    resetFunctionIndex();
+    PR_DecodeStatements();
+    PR_JitReset();
+    PR_ProfileClear();
 }
 
 
@@ -933,6 +1266,13 @@ void PR_Init() {
     Cmd_AddCommand("edicts", ED_PrintEdicts);
     Cmd_AddCommand("edictcount", ED_Count);
     Cmd_AddCommand("profile", PR_Profile_f);
+    Cmd_AddCommand("profile_time", PR_ProfileTime_f);
+    Cmd_AddCommand("profile_dump", PR_ProfileDump_f);
+    Cmd_AddCommand("profile_clear", PR_ProfileClear);
+    Cvar_RegisterVariable(&pr_fastexec);
+    Cvar_RegisterVariable(&pr_optimize);
+    Cvar_RegisterVariable(&pr_profile);
+    PR_JitInit();
     Cvar_RegisterVariable(&nomonsters);
     Cvar_RegisterVariable(&gamecfg);
     Cvar_RegisterVariable(&scratch1);
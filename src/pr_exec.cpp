@@ -41,6 +41,10 @@ qboolean pr_trace;
 dfunction_t *pr_xfunction;
 int pr_xstatement;
 
+// skip the per statement profiling, tracing and runaway counting, and run
+// fused statements
+cvar_t pr_fastexec = {"pr_fastexec", "0"};
+
 
 int pr_argc;
 
@@ -187,6 +191,7 @@ void PR_StackTrace() {
         return;
     }
 
+    pr_stack[pr_depth].s = pr_xstatement;
     pr_stack[pr_depth].f = pr_xfunction;
     for (i = pr_depth; i >= 0; i--) {
         f = pr_stack[i].f;
@@ -200,7 +205,7 @@ void PR_StackTrace() {
                 Con_Printf("In %s : %s\n", filename, getStringByOffset(f->s_name));
             }
         }
-        PR_PrintStatement(pr_statements + pr_stack[i].s);
+        PR_PrintStatement(pr_statements + pr_codestatement[pr_stack[i].s]);
     }
 }
 
@@ -305,7 +310,9 @@ auto PR_EnterFunction(dfunction_t *f) -> int {
     }
 
     pr_xfunction = f;
-    return f->first_statement - 1;    // offset the s++
+    if (pr_profiling)
+        PR_ProfileEnter(f);
+    return pr_statementcode[f->first_statement] - 1;    // offset the s++
 }
 
 /*
@@ -319,6 +326,9 @@ auto PR_LeaveFunction() -> int {
     if (pr_depth <= 0)
         Sys_Error("prog stack underflow");
 
+    if (pr_profiling)
+        PR_ProfileLeave();
+
 // restore locals from the stack
     c = pr_xfunction->locals;
     localstack_used -= c;
@@ -337,289 +347,430 @@ auto PR_LeaveFunction() -> int {
 
 /*
 ====================
-PR_ExecuteProgram
+PR_Execute
+
+The interpreter proper, running pr_decoded. The checked version counts
+every statement for the runaway check and the profiler and honours
+pr_trace; the unchecked one only charges runaway on jumps and calls, which
+is all an endless loop can be made of, leaves pr_xstatement alone between
+calls, and runs fused statements as one.
+
+Dispatch is threaded through a table of label addresses instead of a
+switch, so every handler ends in its own indirect jump.
 ====================
 */
-void PR_ExecuteProgram(func_t fnum) {
-    eval_t *a = nullptr, *b = nullptr, *c = nullptr;
+template<bool checked>
+static void PR_Execute(dfunction_t *f) {
+    static void *const dispatch[] = {
+            &&op_DONE,
+            &&op_MUL_F, &&op_MUL_V, &&op_MUL_FV, &&op_MUL_VF,
+            &&op_DIV_F,
+            &&op_ADD_F, &&op_ADD_V,
+            &&op_SUB_F, &&op_SUB_V,
+            &&op_EQ_F, &&op_EQ_V, &&op_EQ_S, &&op_EQ_E, &&op_EQ_FNC,
+            &&op_NE_F, &&op_NE_V, &&op_NE_S, &&op_NE_E, &&op_NE_FNC,
+            &&op_LE, &&op_GE, &&op_LT, &&op_GT,
+            &&op_LOAD, &&op_LOAD_V, &&op_LOAD, &&op_LOAD, &&op_LOAD, &&op_LOAD,
+            &&op_ADDRESS,
+            &&op_STORE, &&op_STORE_V, &&op_STORE, &&op_STORE, &&op_STORE, &&op_STORE,
+            &&op_STOREP, &&op_STOREP_V, &&op_STOREP, &&op_STOREP, &&op_STOREP, &&op_STOREP,
+            &&op_DONE,
+            &&op_NOT_F, &&op_NOT_V, &&op_NOT_S, &&op_NOT_ENT, &&op_NOT_FNC,
+            &&op_IF, &&op_IFNOT,
+            &&op_CALL, &&op_CALL, &&op_CALL, &&op_CALL, &&op_CALL,
+            &&op_CALL, &&op_CALL, &&op_CALL, &&op_CALL,
+            &&op_STATE,
+            &&op_GOTO,
+            &&op_AND, &&op_OR,
+            &&op_BITAND, &&op_BITOR,
+            &&op_BAD,
+            &&op_EQ_F_IF, &&op_EQ_F_IFNOT,
+            &&op_NE_F_IF, &&op_NE_F_IFNOT,
+            &&op_EQ_E_IF, &&op_EQ_E_IFNOT,
+            &&op_NE_E_IF, &&op_NE_E_IFNOT,
+            &&op_LE_IF, &&op_LE_IFNOT,
+            &&op_GE_IF, &&op_GE_IFNOT,
+            &&op_LT_IF, &&op_LT_IFNOT,
+            &&op_GT_IF, &&op_GT_IFNOT,
+            &&op_NOT_F_IF, &&op_NOT_F_IFNOT,
+            &&op_ADDRESS_STOREP, &&op_ADDRESS_STOREP_V,
+            &&op_LOAD_LOAD
+    };
+    static_assert(std::size(dispatch) == OPX_NUMOPS, "dispatch table out of sync with the opcodes");
+
+    const prstatement_t *st = nullptr;
     int s = 0;
-    dstatement_t *st = nullptr;
-    dfunction_t *f = nullptr, *newf = nullptr;
-    int runaway = 0;
-    int i = 0;
+    int runaway = 100000;
     edict_t *ed = nullptr;
-    int exitdepth = 0;
     eval_t *ptr = nullptr;
+    dfunction_t *newf = nullptr;
 
-    if (!fnum || fnum >= progs->numfunctions) {
-        if (pr_global_struct->self)
-            ED_Print(PROG_TO_EDICT(pr_global_struct->self));
-        Host_Error("PR_ExecuteProgram: NULL function");
-    }
-
-    f = &edictFunctions[fnum];
-
-    runaway = 100000;
     pr_trace = false;
 
 // make a stack frame
-    exitdepth = pr_depth;
+    const auto exitdepth = pr_depth;
 
     s = PR_EnterFunction(f);
 
-    while (true) {
-        s++;    // next statement
-
-        st = &pr_statements[s];
-        a = (eval_t *) &pr_globals[st->a];
-        b = (eval_t *) &pr_globals[st->b];
-        c = (eval_t *) &pr_globals[st->c];
-
-        if (!--runaway)
-            PR_RunError("runaway loop error");
-
-        pr_xfunction->profile++;
-        pr_xstatement = s;
-
-        if (pr_trace)
-            PR_PrintStatement(st);
-
-        switch (st->op) {
-            case OP_ADD_F:
-                c->_float = a->_float + b->_float;
-                break;
-            case OP_ADD_V:
-                c->vector = a->vector + b->vector;
-                break;
-
-            case OP_SUB_F:
-                c->_float = a->_float - b->_float;
-                break;
-            case OP_SUB_V:
-                c->vector = a->vector - b->vector;
-                break;
-
-            case OP_MUL_F:
-                c->_float = a->_float * b->_float;
-                break;
-            case OP_MUL_V:
-                c->_float = glm::dot(a->vector, b->vector);
-                break;
-            case OP_MUL_FV:
-                c->vector = a->_float * b->vector;
-                break;
-            case OP_MUL_VF:
-                c->vector = b->_float * a->vector;
-                break;
-
-            case OP_DIV_F:
-                c->_float = a->_float / b->_float;
-                break;
-
-            case OP_BITAND:
-                c->_float = (int) a->_float & (int) b->_float;
-                break;
-
-            case OP_BITOR:
-                c->_float = (int) a->_float | (int) b->_float;
-                break;
-
-
-            case OP_GE:
-                c->_float = a->_float >= b->_float;
-                break;
-            case OP_LE:
-                c->_float = a->_float <= b->_float;
-                break;
-            case OP_GT:
-                c->_float = a->_float > b->_float;
-                break;
-            case OP_LT:
-                c->_float = a->_float < b->_float;
-                break;
-            case OP_AND:
-                c->_float = a->_float && b->_float;
-                break;
-            case OP_OR:
-                c->_float = a->_float || b->_float;
-                break;
-
-            case OP_NOT_F:
-                c->_float = !a->_float;
-                break;
-            case OP_NOT_V:
-                c->_float = !a->vector[0] && !a->vector[1] && !a->vector[2];
-                break;
-            case OP_NOT_S:
-                c->_float = !a->string || !stringExistsAtOffset(a->string);
-                break;
-            case OP_NOT_FNC:
-                c->_float = !a->function;
-                break;
-            case OP_NOT_ENT:
-                c->_float = (PROG_TO_EDICT(a->edict) == sv.edicts);
-                break;
-
-            case OP_EQ_F:
-                c->_float = a->_float == b->_float;
-                break;
-            case OP_EQ_V:
-                c->_float = a->vector == b->vector;
-                break;
-            case OP_EQ_S:
-                if (getStringByOffset(a->string).empty()) break;
-                c->_float = !Q_strcmp(getStringByOffset(a->string), getStringByOffset(b->string));
-                break;
-            case OP_EQ_E:
-                c->_float = a->_int == b->_int;
-                break;
-            case OP_EQ_FNC:
-                c->_float = a->function == b->function;
-                break;
-
-
-            case OP_NE_F:
-                c->_float = a->_float != b->_float;
-                break;
-            case OP_NE_V:
-                c->_float = a->vector != b->vector;
-                break;
-            case OP_NE_S:
-                c->_float = Q_strcmp(getStringByOffset(a->string), getStringByOffset(b->string));
-                break;
-            case OP_NE_E:
-                c->_float = a->_int != b->_int;
-                break;
-            case OP_NE_FNC:
-                c->_float = a->function != b->function;
-                break;
+#define NEXT_STATEMENT()                                \
+    do {                                                \
+        st = &pr_decoded[++s];                          \
+        if constexpr (checked) {                        \
+            if (!--runaway)                             \
+                PR_RunError("runaway loop error");      \
+            pr_xfunction->profile++;                    \
+            pr_xstatement = s;                          \
+            if (pr_trace)                               \
+                PR_PrintStatement(pr_statements + pr_codestatement[s]); \
+            goto *dispatch[st->op];                     \
+        } else {                                        \
+            goto *dispatch[st->fop];                    \
+        }                                               \
+    } while (false)
+
+#define JUMP_STATEMENT(offset)                          \
+    do {                                                \
+        s += (offset) - 1;    /* offset the s++ */      \
+        if constexpr (!checked) {                       \
+            if (!--runaway) {                           \
+                pr_xstatement = s;                      \
+                PR_RunError("runaway loop error");      \
+            }                                           \
+        }                                               \
+        NEXT_STATEMENT();                               \
+    } while (false)
+
+    NEXT_STATEMENT();
+
+    op_ADD_F:
+    st->c->_float = st->a->_float + st->b->_float;
+    NEXT_STATEMENT();
+    op_ADD_V:
+    st->c->vector = st->a->vector + st->b->vector;
+    NEXT_STATEMENT();
+
+    op_SUB_F:
+    st->c->_float = st->a->_float - st->b->_float;
+    NEXT_STATEMENT();
+    op_SUB_V:
+    st->c->vector = st->a->vector - st->b->vector;
+    NEXT_STATEMENT();
+
+    op_MUL_F:
+    st->c->_float = st->a->_float * st->b->_float;
+    NEXT_STATEMENT();
+    op_MUL_V:
+    st->c->_float = glm::dot(st->a->vector, st->b->vector);
+    NEXT_STATEMENT();
+    op_MUL_FV:
+    st->c->vector = st->a->_float * st->b->vector;
+    NEXT_STATEMENT();
+    op_MUL_VF:
+    st->c->vector = st->b->_float * st->a->vector;
+    NEXT_STATEMENT();
+
+    op_DIV_F:
+    st->c->_float = st->a->_float / st->b->_float;
+    NEXT_STATEMENT();
+
+    op_BITAND:
+    st->c->_float = (int) st->a->_float & (int) st->b->_float;
+    NEXT_STATEMENT();
+
+    op_BITOR:
+    st->c->_float = (int) st->a->_float | (int) st->b->_float;
+    NEXT_STATEMENT();
+
+
+    op_GE:
+    st->c->_float = st->a->_float >= st->b->_float;
+    NEXT_STATEMENT();
+    op_LE:
+    st->c->_float = st->a->_float <= st->b->_float;
+    NEXT_STATEMENT();
+    op_GT:
+    st->c->_float = st->a->_float > st->b->_float;
+    NEXT_STATEMENT();
+    op_LT:
+    st->c->_float = st->a->_float < st->b->_float;
+    NEXT_STATEMENT();
+    op_AND:
+    st->c->_float = st->a->_float && st->b->_float;
+    NEXT_STATEMENT();
+    op_OR:
+    st->c->_float = st->a->_float || st->b->_float;
+    NEXT_STATEMENT();
+
+    op_NOT_F:
+    st->c->_float = !st->a->_float;
+    NEXT_STATEMENT();
+    op_NOT_V:
+    st->c->_float = !st->a->vector[0] && !st->a->vector[1] && !st->a->vector[2];
+    NEXT_STATEMENT();
+    op_NOT_S:
+    st->c->_float = !st->a->string || !stringExistsAtOffset(st->a->string);
+    NEXT_STATEMENT();
+    op_NOT_FNC:
+    st->c->_float = !st->a->function;
+    NEXT_STATEMENT();
+    op_NOT_ENT:
+    st->c->_float = (PROG_TO_EDICT(st->a->edict) == sv.edicts);
+    NEXT_STATEMENT();
+
+    op_EQ_F:
+    st->c->_float = st->a->_float == st->b->_float;
+    NEXT_STATEMENT();
+    op_EQ_V:
+    st->c->_float = st->a->vector == st->b->vector;
+    NEXT_STATEMENT();
+    op_EQ_S:
+    // runtime strings are interned, so equal offsets settle most compares
+    st->c->_float = st->a->string == st->b->string
+                    || getStringByOffset(st->a->string) == getStringByOffset(st->b->string);
+    NEXT_STATEMENT();
+    op_EQ_E:
+    st->c->_float = st->a->_int == st->b->_int;
+    NEXT_STATEMENT();
+    op_EQ_FNC:
+    st->c->_float = st->a->function == st->b->function;
+    NEXT_STATEMENT();
+
+
+    op_NE_F:
+    st->c->_float = st->a->_float != st->b->_float;
+    NEXT_STATEMENT();
+    op_NE_V:
+    st->c->_float = st->a->vector != st->b->vector;
+    NEXT_STATEMENT();
+    op_NE_S:
+    st->c->_float = st->a->string != st->b->string
+                    && getStringByOffset(st->a->string) != getStringByOffset(st->b->string);
+    NEXT_STATEMENT();
+    op_NE_E:
+    st->c->_float = st->a->_int != st->b->_int;
+    NEXT_STATEMENT();
+    op_NE_FNC:
+    st->c->_float = st->a->function != st->b->function;
+    NEXT_STATEMENT();
 
 //==================
-            case OP_STORE_F:
-            case OP_STORE_ENT:
-            case OP_STORE_FLD:        // integers
-            case OP_STORE_S:
-            case OP_STORE_FNC:        // pointers
-                b->_int = a->_int;
-                break;
-            case OP_STORE_V:
-                b->vector = a->vector;
-                break;
-
-            case OP_STOREP_F:
-            case OP_STOREP_ENT:
-            case OP_STOREP_FLD:        // integers
-            case OP_STOREP_S:
-            case OP_STOREP_FNC:        // pointers
-                ptr = (eval_t *) ((byte *) sv.edicts + b->_int);
-                ptr->_int = a->_int;
-                break;
-            case OP_STOREP_V:
-                ptr = (eval_t *) ((byte *) sv.edicts + b->_int);
-                ptr->vector = a->vector;
-                break;
-
-            case OP_ADDRESS:
-                ed = PROG_TO_EDICT(a->edict);
+    op_STORE:        // integers and pointers
+    st->b->_int = st->a->_int;
+    NEXT_STATEMENT();
+    op_STORE_V:
+    st->b->vector = st->a->vector;
+    NEXT_STATEMENT();
+
+    op_STOREP:        // integers and pointers
+    ptr = (eval_t *) ((byte *) sv.edicts + st->b->_int);
+    ptr->_int = st->a->_int;
+    NEXT_STATEMENT();
+    op_STOREP_V:
+    ptr = (eval_t *) ((byte *) sv.edicts + st->b->_int);
+    ptr->vector = st->a->vector;
+    NEXT_STATEMENT();
+
+    op_ADDRESS:
+    ed = PROG_TO_EDICT(st->a->edict);
 #ifdef PARANOID
-                NUM_FOR_EDICT(ed);        // make sure it's in range
+    NUM_FOR_EDICT(ed);        // make sure it's in range
 #endif
-                if (ed == (edict_t *) sv.edicts && sv.state == ss_active)
-                    PR_RunError("assignment to world entity");
-                c->_int = (byte *) ((int *) &ed->v + b->_int) - (byte *) sv.edicts;
-                break;
-
-            case OP_LOAD_F:
-            case OP_LOAD_FLD:
-            case OP_LOAD_ENT:
-            case OP_LOAD_S:
-            case OP_LOAD_FNC:
-                ed = PROG_TO_EDICT(a->edict);
+    if (ed == (edict_t *) sv.edicts && sv.state == ss_active) {
+        pr_xstatement = s;
+        PR_RunError("assignment to world entity");
+    }
+    ed_changed[st->a->edict >> ED_CHANGED_SHIFT] = 1;
+    st->c->_int = (byte *) ((int *) &ed->v + st->b->_int) - (byte *) sv.edicts;
+    NEXT_STATEMENT();
+
+    op_LOAD:
+    ed = PROG_TO_EDICT(st->a->edict);
 #ifdef PARANOID
-                NUM_FOR_EDICT(ed);        // make sure it's in range
+    NUM_FOR_EDICT(ed);        // make sure it's in range
 #endif
-                a = (eval_t *) ((int *) &ed->v + b->_int);
-                c->_int = a->_int;
-                break;
+    ptr = (eval_t *) ((int *) &ed->v + st->b->_int);
+    st->c->_int = ptr->_int;
+    NEXT_STATEMENT();
 
-            case OP_LOAD_V:
-                ed = PROG_TO_EDICT(a->edict);
+    op_LOAD_V:
+    ed = PROG_TO_EDICT(st->a->edict);
 #ifdef PARANOID
-                NUM_FOR_EDICT(ed);        // make sure it's in range
+    NUM_FOR_EDICT(ed);        // make sure it's in range
 #endif
-                a = (eval_t *) ((int *) &ed->v + b->_int);
-                c->vector = a->vector;
-                break;
+    ptr = (eval_t *) ((int *) &ed->v + st->b->_int);
+    st->c->vector = ptr->vector;
+    NEXT_STATEMENT();
 
 //==================
 
-            case OP_IFNOT:
-                if (!a->_int)
-                    s += st->b - 1;    // offset the s++
-                break;
-
-            case OP_IF:
-                if (a->_int)
-                    s += st->b - 1;    // offset the s++
-                break;
-
-            case OP_GOTO:
-                s += st->a - 1;    // offset the s++
-                break;
-
-            case OP_CALL0:
-            case OP_CALL1:
-            case OP_CALL2:
-            case OP_CALL3:
-            case OP_CALL4:
-            case OP_CALL5:
-            case OP_CALL6:
-            case OP_CALL7:
-            case OP_CALL8:
-                pr_argc = st->op - OP_CALL0;
-                if (!a->function)
-                    PR_RunError("NULL function");
-
-                newf = &pr_functions[a->function];
-
-                if (newf->first_statement < 0) {    // negative statements are built in functions
-                    i = -newf->first_statement;
-                    if (i >= pr_numbuiltins)
-                        PR_RunError("Bad builtin call number");
-                    pr_builtins[i]();
-                    break;
-                }
-
-                s = PR_EnterFunction(newf);
-                break;
-
-            case OP_DONE:
-            case OP_RETURN:
-                pr_globals[OFS_RETURN] = pr_globals[st->a];
-                pr_globals[OFS_RETURN + 1] = pr_globals[st->a + 1];
-                pr_globals[OFS_RETURN + 2] = pr_globals[st->a + 2];
-
-                s = PR_LeaveFunction();
-                if (pr_depth == exitdepth)
-                    return;        // all done
-                break;
-
-            case OP_STATE:
-                ed = PROG_TO_EDICT(pr_global_struct->self);
+    op_IFNOT:
+    if (!st->a->_int)
+        JUMP_STATEMENT(st->branch);
+    NEXT_STATEMENT();
+
+    op_IF:
+    if (st->a->_int)
+        JUMP_STATEMENT(st->branch);
+    NEXT_STATEMENT();
+
+    op_GOTO:
+    JUMP_STATEMENT(st->branch);
+
+    op_CALL:
+    pr_xstatement = s;
+    if constexpr (!checked) {
+        if (!--runaway)
+            PR_RunError("runaway loop error");
+    }
+    pr_argc = st->op - OP_CALL0;
+    if (!st->a->function)
+        PR_RunError("NULL function");
+
+    newf = &pr_functions[st->a->function];
+
+    if (newf->first_statement < 0) {    // negative statements are built in functions
+        const auto i = -newf->first_statement;
+        if (i >= pr_numbuiltins)
+            PR_RunError("Bad builtin call number");
+        if (pr_profiling)
+            PR_ProfileEnter(newf);
+        pr_builtins[i]();
+        if (pr_profiling)
+            PR_ProfileLeave();
+        NEXT_STATEMENT();
+    }
+
+    s = PR_EnterFunction(newf);
+    NEXT_STATEMENT();
+
+    op_DONE:        // and OP_RETURN
+    pr_globals[OFS_RETURN] = st->a->_float;
+    pr_globals[OFS_RETURN + 1] = (&st->a->_float)[1];
+    pr_globals[OFS_RETURN + 2] = (&st->a->_float)[2];
+
+    s = PR_LeaveFunction();
+    if (pr_depth == exitdepth)
+        return;        // all done
+    NEXT_STATEMENT();
+
+    op_STATE:
+    ed = PROG_TO_EDICT(pr_global_struct->self);
 #ifdef FPS_20
-                ed->v.nextthink = pr_global_struct->time + 0.05;
+    ed->v.nextthink = pr_global_struct->time + 0.05;
 #else
-                ed->v.nextthink = pr_global_struct->time + 0.1;
+    ed->v.nextthink = pr_global_struct->time + 0.1;
 #endif
-                if (a->_float != ed->v.frame) {
-                    ed->v.frame = a->_float;
-                }
-                ed->v.think = b->function;
-                break;
-
-            default:
-                PR_RunError("Bad opcode %i", st->op);
-        }
+    if (st->a->_float != ed->v.frame) {
+        ed->v.frame = st->a->_float;
+    }
+    ed->v.think = st->b->function;
+    ED_CHANGED(ed);
+    NEXT_STATEMENT();
+
+    op_BAD:
+    pr_xstatement = s;
+    PR_RunError("Bad opcode %i", pr_statements[pr_codestatement[s]].op);
+
+//==================
+// fused statements, only reached by the unchecked version. The second
+// statement is in the next slot, which is stepped over.
+
+#define COMPARE_BRANCH(name, cond)                      \
+    op_##name##_IF:                                     \
+    st->c->_float = (cond);                             \
+    if (st->c->_float) {                                \
+        s++;                                            \
+        JUMP_STATEMENT(st[1].branch);                   \
+    }                                                   \
+    s++;                                                \
+    NEXT_STATEMENT();                                   \
+    op_##name##_IFNOT:                                  \
+    st->c->_float = (cond);                             \
+    if (!st->c->_float) {                               \
+        s++;                                            \
+        JUMP_STATEMENT(st[1].branch);                   \
+    }                                                   \
+    s++;                                                \
+    NEXT_STATEMENT();
+
+    COMPARE_BRANCH(EQ_F, st->a->_float == st->b->_float)
+    COMPARE_BRANCH(NE_F, st->a->_float != st->b->_float)
+    COMPARE_BRANCH(EQ_E, st->a->_int == st->b->_int)
+    COMPARE_BRANCH(NE_E, st->a->_int != st->b->_int)
+    COMPARE_BRANCH(LE, st->a->_float <= st->b->_float)
+    COMPARE_BRANCH(GE, st->a->_float >= st->b->_float)
+    COMPARE_BRANCH(LT, st->a->_float < st->b->_float)
+    COMPARE_BRANCH(GT, st->a->_float > st->b->_float)
+    COMPARE_BRANCH(NOT_F, !st->a->_float)
+
+#undef COMPARE_BRANCH
+
+    op_ADDRESS_STOREP:
+    ed = PROG_TO_EDICT(st->a->edict);
+    if (ed == (edict_t *) sv.edicts && sv.state == ss_active) {
+        pr_xstatement = s;
+        PR_RunError("assignment to world entity");
+    }
+    ed_changed[st->a->edict >> ED_CHANGED_SHIFT] = 1;
+    st->c->_int = (byte *) ((int *) &ed->v + st->b->_int) - (byte *) sv.edicts;
+    ((eval_t *) ((int *) &ed->v + st->b->_int))->_int = st[1].a->_int;
+    s++;
+    NEXT_STATEMENT();
+
+    op_ADDRESS_STOREP_V:
+    ed = PROG_TO_EDICT(st->a->edict);
+    if (ed == (edict_t *) sv.edicts && sv.state == ss_active) {
+        pr_xstatement = s;
+        PR_RunError("assignment to world entity");
+    }
+    ed_changed[st->a->edict >> ED_CHANGED_SHIFT] = 1;
+    st->c->_int = (byte *) ((int *) &ed->v + st->b->_int) - (byte *) sv.edicts;
+    ((eval_t *) ((int *) &ed->v + st->b->_int))->vector = st[1].a->vector;
+    s++;
+    NEXT_STATEMENT();
+
+    op_LOAD_LOAD:
+    ed = PROG_TO_EDICT(st->a->edict);
+    st->c->_int = ((eval_t *) ((int *) &ed->v + st->b->_int))->_int;
+    st[1].c->_int = ((eval_t *) ((int *) &ed->v + st[1].b->_int))->_int;
+    s++;
+    NEXT_STATEMENT();
+
+#undef JUMP_STATEMENT
+#undef NEXT_STATEMENT
+}
+
+/*
+====================
+PR_RunFunction
+
+Interprets f from its entry to its return
+====================
+*/
+void PR_RunFunction(dfunction_t *f) {
+    if (pr_fastexec.value)
+        PR_Execute<false>(f);
+    else
+        PR_Execute<true>(f);
+}
+
+/*
+====================
+PR_ExecuteProgram
+====================
+*/
+void PR_ExecuteProgram(func_t fnum) {
+    if (!fnum || fnum >= progs->numfunctions) {
+        if (pr_global_struct->self)
+            ED_Print(PROG_TO_EDICT(pr_global_struct->self));
+        Host_Error("PR_ExecuteProgram: NULL function");
     }
 
+    if (!pr_depth)
+        PR_ProfileStart();
+
+    if (pr_jit)
+        PR_JitExecute(fnum);
+    else
+        PR_RunFunction(&edictFunctions[fnum]);
 }
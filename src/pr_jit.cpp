@@ -0,0 +1,757 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// pr_jit.cpp -- x86-64 native code for the progs, enabled with -progsjit
+
+#include <algorithm>
+#include <cstring>
+#include "util.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define PR_JIT_SUPPORTED
+#endif
+
+qboolean pr_jit;
+
+#ifdef PR_JIT_SUPPORTED
+
+/*
+==============================================================================
+
+Every QC function is translated on its first call, straight from
+pr_statements. Globals stay in pr_globals and entity fields in sv.edicts,
+so the builtins and the interpreter see exactly the same state. While
+native code runs:
+
+    rbx = pr_globals
+    r12 = sv.edicts
+    r13 = &jit_runaway
+
+Calls, string compares and OP_STATE go through small C++ helpers. A
+function using an opcode the translator doesn't know is left to the
+interpreter.
+
+==============================================================================
+*/
+
+using jitcode_t = void (*)();
+
+#define JIT_ARENA_SIZE    (16 * 1024 * 1024)
+
+static byte *jit_arena;
+static std::size_t jit_arenaused;
+
+static std::vector<jitcode_t> jit_functions;
+static std::vector<bool> jit_failed;
+
+static std::vector<byte> jit_buf;
+static int jit_runaway;
+
+// register numbers as encoded in modrm
+#define R_EAX    0
+#define R_ECX    1
+#define R_EDX    2
+
+#define X_XMM0    0
+#define X_XMM1    1
+#define X_XMM2    2
+#define X_XMM3    3
+
+// opcodes taking a [rbx + disp32] operand
+#define I_MOV_LOAD        0x8b
+#define I_MOV_STORE        0x89
+#define I_CMP            0x3b
+#define I_MOVSS_LOAD    0xf3, 0x0f, 0x10
+#define I_MOVSS_STORE    0xf3, 0x0f, 0x11
+#define I_ADDSS            0xf3, 0x0f, 0x58
+#define I_MULSS            0xf3, 0x0f, 0x59
+#define I_SUBSS            0xf3, 0x0f, 0x5c
+#define I_DIVSS            0xf3, 0x0f, 0x5e
+#define I_CMPSS            0xf3, 0x0f, 0xc2
+#define I_CVTTSS2SI        0xf3, 0x0f, 0x2c
+#define I_MOVSXD        0x48, 0x63
+
+// cmpss predicates
+#define CMP_EQ    0
+#define CMP_LT    1
+#define CMP_LE    2
+#define CMP_NEQ    4
+
+#define FLOAT_ONE    0x3f800000
+
+static void Jit_Bytes(std::initializer_list<int> bytes) {
+    for (auto b: bytes)
+        jit_buf.push_back(static_cast<byte>(b));
+}
+
+static void Jit_Int(int v) {
+    for (int i = 0; i < 4; i++)
+        jit_buf.push_back(static_cast<byte>(v >> (i * 8)));
+}
+
+static void Jit_Ptr(const void *p) {
+    const auto v = reinterpret_cast<std::uintptr_t>(p);
+    for (int i = 0; i < 8; i++)
+        jit_buf.push_back(static_cast<byte>(v >> (i * 8)));
+}
+
+/*
+=============
+Jit_Global
+
+op reg, [rbx + ofs * 4], for the global at ofs
+=============
+*/
+static void Jit_Global(std::initializer_list<int> opcode, int reg, int ofs) {
+    Jit_Bytes(opcode);
+    Jit_Bytes({0x83 | reg << 3});
+    Jit_Int(ofs * 4);
+}
+
+// op dst, src on two xmm registers
+static void Jit_XmmXmm(std::initializer_list<int> opcode, int dst, int src) {
+    Jit_Bytes(opcode);
+    Jit_Bytes({0xc0 | dst << 3 | src});
+}
+
+/*
+=============
+Jit_CallHelper
+
+Calls helper(s) and returns to the following code
+=============
+*/
+static void Jit_CallHelper(void (*helper)(int), int s) {
+    Jit_Bytes({0xbf});        // mov edi, s
+    Jit_Int(s);
+    Jit_Bytes({0x48, 0xb8});    // mov rax, helper
+    Jit_Ptr(reinterpret_cast<const void *>(helper));
+    Jit_Bytes({0xff, 0xd0});    // call rax
+}
+
+#define JIT_CALLHELPER_SIZE    17
+
+// turns the compare mask in xmm0 into 0.0 or 1.0 at the global c
+static void Jit_StoreMask(int c) {
+    Jit_Bytes({0x66, 0x0f, 0x7e, 0xc0});        // movd eax, xmm0
+    Jit_Bytes({0x25});                            // and eax, 1.0f
+    Jit_Int(FLOAT_ONE);
+    Jit_Global({I_MOV_STORE}, R_EAX, c);
+}
+
+// turns the condition code from the last compare into 0.0 or 1.0 at c
+static void Jit_StoreFlag(int setcc, int c) {
+    Jit_Bytes({0x0f, setcc, 0xc0});                // setcc al
+    Jit_Bytes({0x0f, 0xb6, 0xc0});                // movzx eax, al
+    Jit_Bytes({0xf7, 0xd8});                    // neg eax
+    Jit_Bytes({0x25});                            // and eax, 1.0f
+    Jit_Int(FLOAT_ONE);
+    Jit_Global({I_MOV_STORE}, R_EAX, c);
+}
+
+#define SETCC_E        0x94
+#define SETCC_NE    0x95
+
+// rax = the address of field b of entity a
+static void Jit_FieldAddress(int a, int b) {
+    Jit_Global({I_MOVSXD}, R_EAX, a);
+    Jit_Global({I_MOVSXD}, R_ECX, b);
+    Jit_Bytes({0x4c, 0x01, 0xe0});                // add rax, r12
+    Jit_Bytes({0x48, 0x8d, 0x84, 0x88});        // lea rax, [rax + rcx * 4 + v]
+    Jit_Int(offsetof(edict_t, v));
+}
+
+// copies count ints from [rax] to the global c
+static void Jit_LoadPointer(int c, int count) {
+    for (int i = 0; i < count; i++) {
+        Jit_Bytes({0x8b, 0x90});                // mov edx, [rax + i * 4]
+        Jit_Int(i * 4);
+        Jit_Global({I_MOV_STORE}, R_EDX, c + i);
+    }
+}
+
+// copies count ints from the global a to [rax]
+static void Jit_StorePointer(int a, int count) {
+    for (int i = 0; i < count; i++) {
+        Jit_Global({I_MOV_LOAD}, R_EDX, a + i);
+        Jit_Bytes({0x89, 0x90});                // mov [rax + i * 4], edx
+        Jit_Int(i * 4);
+    }
+}
+
+static void Jit_Copy(int from, int to, int count) {
+    for (int i = 0; i < count; i++) {
+        Jit_Global({I_MOV_LOAD}, R_EAX, from + i);
+        Jit_Global({I_MOV_STORE}, R_EAX, to + i);
+    }
+}
+
+static void Jit_Epilogue() {
+    Jit_Bytes({0x41, 0x5d});        // pop r13
+    Jit_Bytes({0x41, 0x5c});        // pop r12
+    Jit_Bytes({0x5b});                // pop rbx
+    Jit_Bytes({0xc3});                // ret
+}
+
+/*
+==============================================================================
+
+HELPERS
+
+Called from native code with the pr_statements index of the statement
+they stand in for.
+
+==============================================================================
+*/
+
+static void PR_JitRun(dfunction_t *f, func_t fnum);
+
+static void PR_JitRunaway(int s) {
+    pr_xstatement = pr_statementcode[s];
+    PR_RunError("runaway loop error");
+}
+
+static void PR_JitWorldAddress(int s) {
+    if (sv.state != ss_active)
+        return;
+    pr_xstatement = pr_statementcode[s];
+    PR_RunError("assignment to world entity");
+}
+
+static void PR_JitCall(int s) {
+    const auto *st = &pr_statements[s];
+
+    pr_xstatement = pr_statementcode[s];
+    if (!--jit_runaway)
+        PR_RunError("runaway loop error");
+
+    pr_argc = st->op - OP_CALL0;
+    const auto fnum = ((eval_t *) &pr_globals[(unsigned short) st->a])->function;
+    if (!fnum)
+        PR_RunError("NULL function");
+
+    auto *newf = &pr_functions[fnum];
+    if (newf->first_statement < 0) {    // negative statements are built in functions
+        const auto i = -newf->first_statement;
+        if (i >= pr_numbuiltins)
+            PR_RunError("Bad builtin call number");
+        if (pr_profiling)
+            PR_ProfileEnter(newf);
+        pr_builtins[i]();
+        if (pr_profiling)
+            PR_ProfileLeave();
+        return;
+    }
+
+    PR_JitRun(newf, fnum);
+}
+
+// the statements that are rare or too involved to be worth native code
+static void PR_JitStatement(int s) {
+    const auto *st = &pr_statements[s];
+    auto *a = (eval_t *) &pr_globals[(unsigned short) st->a];
+    auto *b = (eval_t *) &pr_globals[(unsigned short) st->b];
+    auto *c = (eval_t *) &pr_globals[(unsigned short) st->c];
+    edict_t *ed = nullptr;
+
+    switch (st->op) {
+        case OP_EQ_S:
+            c->_float = a->string == b->string || getStringByOffset(a->string) == getStringByOffset(b->string);
+            break;
+        case OP_NE_S:
+            c->_float = a->string != b->string && getStringByOffset(a->string) != getStringByOffset(b->string);
+            break;
+        case OP_NOT_S:
+            c->_float = !a->string || !stringExistsAtOffset(a->string);
+            break;
+        case OP_STATE:
+            ed = PROG_TO_EDICT(pr_global_struct->self);
+#ifdef FPS_20
+            ed->v.nextthink = pr_global_struct->time + 0.05;
+#else
+            ed->v.nextthink = pr_global_struct->time + 0.1;
+#endif
+            if (a->_float != ed->v.frame) {
+                ed->v.frame = a->_float;
+            }
+            ed->v.think = b->function;
+            ED_CHANGED(ed);
+            break;
+        default:
+            pr_xstatement = pr_statementcode[s];
+            PR_RunError("Bad opcode %i", st->op);
+    }
+}
+
+/*
+==============================================================================
+
+TRANSLATION
+
+==============================================================================
+*/
+
+/*
+=============
+PR_JitStatementCode
+
+Emits one statement. Jumps are left for the caller to patch, with
+their positions added to fixups. Returns false for an opcode that has no
+translation.
+=============
+*/
+static auto PR_JitStatementCode(int s, std::vector<std::pair<std::size_t, int>> &fixups) -> bool {
+    const auto *st = &pr_statements[s];
+    const int a = (unsigned short) st->a;
+    const int b = (unsigned short) st->b;
+    const int c = (unsigned short) st->c;
+
+    // a jump to s + offset, charging the runaway counter when it goes back
+    auto jump = [s, &fixups](int offset) {
+        if (offset <= 0) {
+            Jit_Bytes({0x41, 0x83, 0x6d, 0x00, 0x01});    // sub dword [r13], 1
+            Jit_Bytes({0x75, JIT_CALLHELPER_SIZE});        // jnz past the error
+            Jit_CallHelper(PR_JitRunaway, s);
+        }
+        Jit_Bytes({0xe9});                                // jmp
+        fixups.emplace_back(jit_buf.size(), s + offset);
+        Jit_Int(0);
+    };
+
+    // the same, taken when the global a is zero or non zero
+    auto branch = [&jump, a](bool ifzero, int offset) {
+        Jit_Global({I_MOV_LOAD}, R_EAX, a);
+        Jit_Bytes({0x85, 0xc0});                        // test eax, eax
+        Jit_Bytes({ifzero ? 0x75 : 0x74, 0});            // skip unless taken
+        const auto skip = jit_buf.size();
+        jump(offset);
+        jit_buf[skip - 1] = static_cast<byte>(jit_buf.size() - skip);
+    };
+
+    auto arith = [a, b, c](std::initializer_list<int> opcode) {
+        Jit_Global({I_MOVSS_LOAD}, X_XMM0, a);
+        Jit_Global(opcode, X_XMM0, b);
+        Jit_Global({I_MOVSS_STORE}, X_XMM0, c);
+    };
+
+    auto arith_v = [a, b, c](std::initializer_list<int> opcode) {
+        for (int i = 0; i < 3; i++) {
+            Jit_Global({I_MOVSS_LOAD}, i, a + i);
+            Jit_Global(opcode, i, b + i);
+        }
+        for (int i = 0; i < 3; i++)
+            Jit_Global({I_MOVSS_STORE}, i, c + i);
+    };
+
+    // scale the vector at v by the float at f
+    auto scale_v = [c](int f, int v) {
+        for (int i = 0; i < 3; i++) {
+            Jit_Global({I_MOVSS_LOAD}, i, f);
+            Jit_Global({I_MULSS}, i, v + i);
+        }
+        for (int i = 0; i < 3; i++)
+            Jit_Global({I_MOVSS_STORE}, i, c + i);
+    };
+
+    auto compare = [c](int x, int y, int predicate) {
+        Jit_Global({I_MOVSS_LOAD}, X_XMM0, x);
+        Jit_Global({I_CMPSS}, X_XMM0, y);
+        Jit_Bytes({predicate});
+        Jit_StoreMask(c);
+    };
+
+    auto compare_v = [a, b, c](int predicate, int combine) {
+        for (int i = 0; i < 3; i++) {
+            Jit_Global({I_MOVSS_LOAD}, i, a + i);
+            Jit_Global({I_CMPSS}, i, b + i);
+            Jit_Bytes({predicate});
+        }
+        Jit_XmmXmm({0x0f, combine}, X_XMM0, X_XMM1);
+        Jit_XmmXmm({0x0f, combine}, X_XMM0, X_XMM2);
+        Jit_StoreMask(c);
+    };
+
+    // x != 0 as a mask in the xmm register reg, with xmm3 holding zero
+    auto truth = [](int reg, int x) {
+        Jit_Global({I_MOVSS_LOAD}, reg, x);
+        Jit_XmmXmm({I_CMPSS}, reg, X_XMM3);
+        Jit_Bytes({CMP_NEQ});
+    };
+
+    auto logic = [a, b, c, &truth](int combine) {
+        Jit_XmmXmm({0x0f, 0x57}, X_XMM3, X_XMM3);        // xorps xmm3, xmm3
+        truth(X_XMM0, a);
+        truth(X_XMM1, b);
+        Jit_XmmXmm({0x0f, combine}, X_XMM0, X_XMM1);
+        Jit_StoreMask(c);
+    };
+
+    auto bits = [a, b, c](int combine) {
+        Jit_Global({I_CVTTSS2SI}, R_EAX, a);
+        Jit_Global({I_CVTTSS2SI}, R_ECX, b);
+        Jit_Bytes({combine, 0xc8});                        // and/or eax, ecx
+        Jit_Bytes({0xf3, 0x0f, 0x2a, 0xc0});            // cvtsi2ss xmm0, eax
+        Jit_Global({I_MOVSS_STORE}, X_XMM0, c);
+    };
+
+    auto equal_int = [a, b, c](int setcc) {
+        Jit_Global({I_MOV_LOAD}, R_EAX, a);
+        Jit_Global({I_CMP}, R_EAX, b);
+        Jit_StoreFlag(setcc, c);
+    };
+
+    auto not_int = [a, c]() {
+        Jit_Global({I_MOV_LOAD}, R_EAX, a);
+        Jit_Bytes({0x85, 0xc0});                        // test eax, eax
+        Jit_StoreFlag(SETCC_E, c);
+    };
+
+    switch (st->op) {
+        case OP_ADD_F: arith({I_ADDSS}); break;
+        case OP_SUB_F: arith({I_SUBSS}); break;
+        case OP_MUL_F: arith({I_MULSS}); break;
+        case OP_DIV_F: arith({I_DIVSS}); break;
+        case OP_ADD_V: arith_v({I_ADDSS}); break;
+        case OP_SUB_V: arith_v({I_SUBSS}); break;
+        case OP_MUL_FV: scale_v(a, b); break;
+        case OP_MUL_VF: scale_v(b, a); break;
+
+        case OP_MUL_V:
+            Jit_Global({I_MOVSS_LOAD}, X_XMM0, a);
+            Jit_Global({I_MULSS}, X_XMM0, b);
+            for (int i = 1; i < 3; i++) {
+                Jit_Global({I_MOVSS_LOAD}, X_XMM1, a + i);
+                Jit_Global({I_MULSS}, X_XMM1, b + i);
+                Jit_XmmXmm({I_ADDSS}, X_XMM0, X_XMM1);
+            }
+            Jit_Global({I_MOVSS_STORE}, X_XMM0, c);
+            break;
+
+        case OP_BITAND: bits(0x21); break;
+        case OP_BITOR: bits(0x09); break;
+
+        case OP_EQ_F: compare(a, b, CMP_EQ); break;
+        case OP_NE_F: compare(a, b, CMP_NEQ); break;
+        case OP_LT: compare(a, b, CMP_LT); break;
+        case OP_LE: compare(a, b, CMP_LE); break;
+        case OP_GT: compare(b, a, CMP_LT); break;
+        case OP_GE: compare(b, a, CMP_LE); break;
+        case OP_EQ_V: compare_v(CMP_EQ, 0x54); break;        // andps
+        case OP_NE_V: compare_v(CMP_NEQ, 0x56); break;        // orps
+
+        case OP_EQ_E:
+        case OP_EQ_FNC:
+            equal_int(SETCC_E);
+            break;
+        case OP_NE_E:
+        case OP_NE_FNC:
+            equal_int(SETCC_NE);
+            break;
+
+        case OP_AND: logic(0x54); break;
+        case OP_OR: logic(0x56); break;
+
+        case OP_NOT_F:
+            Jit_XmmXmm({0x0f, 0x57}, X_XMM3, X_XMM3);
+            Jit_Global({I_MOVSS_LOAD}, X_XMM0, a);
+            Jit_XmmXmm({I_CMPSS}, X_XMM0, X_XMM3);
+            Jit_Bytes({CMP_EQ});
+            Jit_StoreMask(c);
+            break;
+        case OP_NOT_V:
+            Jit_XmmXmm({0x0f, 0x57}, X_XMM3, X_XMM3);
+            for (int i = 0; i < 3; i++) {
+                Jit_Global({I_MOVSS_LOAD}, i, a + i);
+                Jit_XmmXmm({I_CMPSS}, i, X_XMM3);
+                Jit_Bytes({CMP_EQ});
+            }
+            Jit_XmmXmm({0x0f, 0x54}, X_XMM0, X_XMM1);
+            Jit_XmmXmm({0x0f, 0x54}, X_XMM0, X_XMM2);
+            Jit_StoreMask(c);
+            break;
+        case OP_NOT_ENT:        // entity 0 is the world
+        case OP_NOT_FNC:
+            not_int();
+            break;
+
+        case OP_STORE_F:
+        case OP_STORE_ENT:
+        case OP_STORE_FLD:
+        case OP_STORE_S:
+        case OP_STORE_FNC:
+            Jit_Copy(a, b, 1);
+            break;
+        case OP_STORE_V:
+            Jit_Copy(a, b, 3);
+            break;
+
+        case OP_STOREP_F:
+        case OP_STOREP_ENT:
+        case OP_STOREP_FLD:
+        case OP_STOREP_S:
+        case OP_STOREP_FNC:
+        case OP_STOREP_V:
+            Jit_Global({I_MOVSXD}, R_EAX, b);
+            Jit_Bytes({0x4c, 0x01, 0xe0});                // add rax, r12
+            Jit_StorePointer(a, st->op == OP_STOREP_V ? 3 : 1);
+            break;
+
+        case OP_LOAD_F:
+        case OP_LOAD_ENT:
+        case OP_LOAD_FLD:
+        case OP_LOAD_S:
+        case OP_LOAD_FNC:
+        case OP_LOAD_V:
+            Jit_FieldAddress(a, b);
+            Jit_LoadPointer(c, st->op == OP_LOAD_V ? 3 : 1);
+            break;
+
+        case OP_ADDRESS:
+            Jit_Global({I_MOV_LOAD}, R_EAX, a);
+            Jit_Bytes({0x85, 0xc0});                    // test eax, eax
+            Jit_Bytes({0x75, JIT_CALLHELPER_SIZE});        // jnz past the check
+            Jit_CallHelper(PR_JitWorldAddress, s);
+            Jit_Global({I_MOV_LOAD}, R_EAX, a);
+            Jit_Bytes({0x89, 0xc2});                    // mov edx, eax
+            Jit_Bytes({0xc1, 0xea, ED_CHANGED_SHIFT});    // shr edx, ED_CHANGED_SHIFT
+            Jit_Bytes({0x48, 0xb9});                    // mov rcx, &ed_changed
+            Jit_Ptr(&ed_changed);
+            Jit_Bytes({0x48, 0x8b, 0x09});                // mov rcx, [rcx]
+            Jit_Bytes({0xc6, 0x04, 0x11, 0x01});        // mov byte [rcx + rdx], 1
+            Jit_Global({I_MOV_LOAD}, R_ECX, b);
+            Jit_Bytes({0x8d, 0x84, 0x88});                // lea eax, [rax + rcx * 4 + v]
+            Jit_Int(offsetof(edict_t, v));
+            Jit_Global({I_MOV_STORE}, R_EAX, c);
+            break;
+
+        case OP_IF: branch(false, st->b); break;
+        case OP_IFNOT: branch(true, st->b); break;
+        case OP_GOTO: jump(st->a); break;
+
+        case OP_CALL0:
+        case OP_CALL1:
+        case OP_CALL2:
+        case OP_CALL3:
+        case OP_CALL4:
+        case OP_CALL5:
+        case OP_CALL6:
+        case OP_CALL7:
+        case OP_CALL8:
+            Jit_CallHelper(PR_JitCall, s);
+            break;
+
+        case OP_DONE:
+        case OP_RETURN:
+            Jit_Copy(a, OFS_RETURN, 3);
+            Jit_Epilogue();
+            break;
+
+        case OP_EQ_S:
+        case OP_NE_S:
+        case OP_NOT_S:
+        case OP_STATE:
+            Jit_CallHelper(PR_JitStatement, s);
+            break;
+
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+// statements after which control never reaches the next one
+static auto PR_JitEndsBlock(int op) -> bool {
+    return op == OP_GOTO || op == OP_DONE || op == OP_RETURN;
+}
+
+/*
+=============
+PR_JitCompile
+
+Translates the statements reachable from the entry of f. Returns nullptr
+if anything can't be translated or the code arena is full.
+=============
+*/
+static auto PR_JitCompile(const dfunction_t *f) -> jitcode_t {
+    const auto numstatements = progs->numstatements;
+
+// find the statements, following jumps rather than trusting the layout
+    std::vector<int> statements;
+    std::vector<bool> seen(numstatements);
+    std::vector<int> work = {f->first_statement};
+
+    while (!work.empty()) {
+        const auto s = work.back();
+        work.pop_back();
+        if (s < 0 || s >= numstatements)
+            return nullptr;
+        if (seen[s])
+            continue;
+        seen[s] = true;
+        statements.push_back(s);
+
+        const auto *st = &pr_statements[s];
+        if (st->op == OP_GOTO)
+            work.push_back(s + st->a);
+        else if (st->op == OP_IF || st->op == OP_IFNOT)
+            work.push_back(s + st->b);
+        if (!PR_JitEndsBlock(st->op))
+            work.push_back(s + 1);
+    }
+    std::sort(statements.begin(), statements.end());
+
+// emit them in order, so a statement falls through into the next one
+    std::vector<std::size_t> labels(numstatements);
+    std::vector<std::pair<std::size_t, int>> fixups;
+
+    jit_buf.clear();
+    Jit_Bytes({0x53});                        // push rbx
+    Jit_Bytes({0x41, 0x54});                // push r12
+    Jit_Bytes({0x41, 0x55});                // push r13
+    Jit_Bytes({0x48, 0xbb});                // mov rbx, pr_globals
+    Jit_Ptr(pr_globals);
+    Jit_Bytes({0x48, 0xb8});                // mov rax, &sv.edicts
+    Jit_Ptr(&sv.edicts);
+    Jit_Bytes({0x4c, 0x8b, 0x20});            // mov r12, [rax]
+    Jit_Bytes({0x49, 0xbd});                // mov r13, &jit_runaway
+    Jit_Ptr(&jit_runaway);
+
+    for (const auto s: statements) {
+        labels[s] = jit_buf.size();
+        if (!PR_JitStatementCode(s, fixups))
+            return nullptr;
+    }
+
+    for (const auto &[pos, target]: fixups) {
+        const auto rel = static_cast<int>(labels[target] - (pos + 4));
+        std::memcpy(&jit_buf[pos], &rel, 4);
+    }
+
+// copy it into the arena
+    const auto start = (jit_arenaused + 15) & ~static_cast<std::size_t>(15);
+    if (start + jit_buf.size() > JIT_ARENA_SIZE)
+        return nullptr;
+
+    const auto pagesize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    auto *pages = jit_arena + (start & ~(pagesize - 1));
+    const auto length = jit_arena + start + jit_buf.size() - pages;
+
+    if (mprotect(pages, length, PROT_READ | PROT_WRITE))
+        return nullptr;
+    std::memcpy(jit_arena + start, jit_buf.data(), jit_buf.size());
+    if (mprotect(pages, length, PROT_READ | PROT_EXEC))
+        Sys_Error("PR_JitCompile: can't make the code executable");
+
+    jit_arenaused = start + jit_buf.size();
+    return reinterpret_cast<jitcode_t>(jit_arena + start);
+}
+
+/*
+=============
+PR_JitRun
+
+Enters f, runs it to its return and leaves it. Functions that didn't
+translate are interpreted.
+=============
+*/
+static void PR_JitRun(dfunction_t *f, func_t fnum) {
+    if (!jit_functions[fnum] && !jit_failed[fnum]) {
+        jit_functions[fnum] = PR_JitCompile(f);
+        if (!jit_functions[fnum]) {
+            jit_failed[fnum] = true;
+            Con_DPrintf("PR_JitRun: %s left to the interpreter\n", getStringByOffset(f->s_name).data());
+        }
+    }
+
+    if (!jit_functions[fnum]) {
+        PR_RunFunction(f);
+        return;
+    }
+
+    PR_EnterFunction(f);
+    jit_functions[fnum]();
+    PR_LeaveFunction();
+}
+
+/*
+=============
+PR_JitExecute
+
+PR_ExecuteProgram with -progsjit
+=============
+*/
+void PR_JitExecute(func_t fnum) {
+    jit_runaway = 100000;
+    pr_trace = false;
+    PR_JitRun(&edictFunctions[fnum], fnum);
+}
+
+/*
+=============
+PR_JitReset
+
+Throws away the code for the previous progs
+=============
+*/
+void PR_JitReset() {
+    if (!pr_jit)
+        return;
+
+    jit_arenaused = 0;
+    jit_functions.assign(progs->numfunctions, nullptr);
+    jit_failed.assign(progs->numfunctions, false);
+}
+
+/*
+=============
+PR_JitInit
+=============
+*/
+void PR_JitInit() {
+    if (!COM_CheckParm("-progsjit"))
+        return;
+
+    auto *arena = mmap(nullptr, JIT_ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) {
+        Con_Printf("PR_JitInit: can't map the code arena, progs will be interpreted\n");
+        return;
+    }
+
+    jit_arena = static_cast<byte *>(arena);
+    pr_jit = true;
+}
+
+#else
+
+void PR_JitExecute(func_t fnum) {
+    PR_RunFunction(&edictFunctions[fnum]);
+}
+
+void PR_JitReset() {
+}
+
+void PR_JitInit() {
+    if (COM_CheckParm("-progsjit"))
+        Con_Printf("-progsjit is only supported on x86-64 Linux, progs will be interpreted\n");
+}
+
+#endif
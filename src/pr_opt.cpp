@@ -0,0 +1,580 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// pr_opt.cpp -- load time decoding and optimization of the progs statements
+
+#include <algorithm>
+#include <deque>
+#include "util.hpp"
+
+std::vector<prstatement_t> pr_decoded;
+std::vector<int> pr_codestatement;
+std::vector<int> pr_statementcode;
+
+cvar_t pr_optimize = {"pr_optimize", "1"};
+
+// values of folded statements, stored through OP_STORE_F/OP_STORE_V.
+// a deque so the decoded statements can point into it while it grows
+static std::deque<eval_t> pr_folded;
+
+enum class stmt_action {
+    keep,
+    drop,
+    fold,        // becomes a store of a folded value
+    jump,        // conditional jump on a constant that is always taken
+    fuse        // runs together with the following statement
+};
+
+struct stmt_info {
+    stmt_action action = stmt_action::keep;
+    unsigned short fop = 0;
+    eval_t *folded = nullptr;
+};
+
+/*
+==============================================================================
+
+OPERAND USAGE
+
+==============================================================================
+*/
+
+// number of globals read through operand a
+static constexpr auto PR_ReadsA(int op) -> int {
+    switch (op) {
+        case OP_GOTO:
+            return 0;
+        case OP_ADD_V:
+        case OP_SUB_V:
+        case OP_MUL_V:
+        case OP_MUL_VF:
+        case OP_EQ_V:
+        case OP_NE_V:
+        case OP_NOT_V:
+        case OP_STORE_V:
+        case OP_STOREP_V:
+        case OP_RETURN:
+        case OP_DONE:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+// number of globals read through operand b
+static constexpr auto PR_ReadsB(int op) -> int {
+    switch (op) {
+        case OP_ADD_V:
+        case OP_SUB_V:
+        case OP_MUL_V:
+        case OP_MUL_FV:
+        case OP_EQ_V:
+        case OP_NE_V:
+            return 3;
+        case OP_STORE_F:
+        case OP_STORE_V:
+        case OP_STORE_S:
+        case OP_STORE_ENT:
+        case OP_STORE_FLD:
+        case OP_STORE_FNC:
+        case OP_NOT_F:
+        case OP_NOT_V:
+        case OP_NOT_S:
+        case OP_NOT_ENT:
+        case OP_NOT_FNC:
+        case OP_IF:
+        case OP_IFNOT:
+        case OP_GOTO:
+        case OP_CALL0:
+        case OP_CALL1:
+        case OP_CALL2:
+        case OP_CALL3:
+        case OP_CALL4:
+        case OP_CALL5:
+        case OP_CALL6:
+        case OP_CALL7:
+        case OP_CALL8:
+        case OP_RETURN:
+        case OP_DONE:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+// number of globals written, and through which operand
+static auto PR_Writes(const dstatement_t *st, int &ofs) -> int {
+    switch (st->op) {
+        case OP_STORE_F:
+        case OP_STORE_S:
+        case OP_STORE_ENT:
+        case OP_STORE_FLD:
+        case OP_STORE_FNC:
+            ofs = (unsigned short) st->b;
+            return 1;
+        case OP_STORE_V:
+            ofs = (unsigned short) st->b;
+            return 3;
+        case OP_ADD_V:
+        case OP_SUB_V:
+        case OP_MUL_FV:
+        case OP_MUL_VF:
+        case OP_LOAD_V:
+            ofs = (unsigned short) st->c;
+            return 3;
+        case OP_STOREP_F:
+        case OP_STOREP_V:
+        case OP_STOREP_S:
+        case OP_STOREP_ENT:
+        case OP_STOREP_FLD:
+        case OP_STOREP_FNC:
+        case OP_RETURN:
+        case OP_DONE:
+        case OP_IF:
+        case OP_IFNOT:
+        case OP_GOTO:
+        case OP_CALL0:
+        case OP_CALL1:
+        case OP_CALL2:
+        case OP_CALL3:
+        case OP_CALL4:
+        case OP_CALL5:
+        case OP_CALL6:
+        case OP_CALL7:
+        case OP_CALL8:
+        case OP_STATE:
+            return 0;
+        default:
+            ofs = (unsigned short) st->c;
+            return 1;
+    }
+}
+
+static constexpr auto PR_IsJump(int op) -> bool {
+    return op == OP_IF || op == OP_IFNOT || op == OP_GOTO;
+}
+
+static auto PR_JumpTarget(const dstatement_t *st, int s) -> int {
+    return s + (st->op == OP_GOTO ? st->a : st->b);
+}
+
+/*
+==============================================================================
+
+FOLDING
+
+==============================================================================
+*/
+
+/*
+============
+PR_FoldStatement
+
+Works out the result of a statement whose inputs are all constant.
+Returns false for statements that can't be folded.
+============
+*/
+static auto PR_FoldStatement(const dstatement_t *st, eval_t &out) -> bool {
+    const auto *a = (eval_t *) &pr_globals[(unsigned short) st->a];
+    const auto *b = (eval_t *) &pr_globals[(unsigned short) st->b];
+
+    switch (st->op) {
+        case OP_ADD_F:
+            out._float = a->_float + b->_float;
+            return true;
+        case OP_ADD_V:
+            out.vector = a->vector + b->vector;
+            return true;
+        case OP_SUB_F:
+            out._float = a->_float - b->_float;
+            return true;
+        case OP_SUB_V:
+            out.vector = a->vector - b->vector;
+            return true;
+        case OP_MUL_F:
+            out._float = a->_float * b->_float;
+            return true;
+        case OP_MUL_V:
+            out._float = glm::dot(a->vector, b->vector);
+            return true;
+        case OP_MUL_FV:
+            out.vector = a->_float * b->vector;
+            return true;
+        case OP_MUL_VF:
+            out.vector = b->_float * a->vector;
+            return true;
+        case OP_DIV_F:
+            out._float = a->_float / b->_float;
+            return true;
+        case OP_BITAND:
+            out._float = (int) a->_float & (int) b->_float;
+            return true;
+        case OP_BITOR:
+            out._float = (int) a->_float | (int) b->_float;
+            return true;
+        case OP_GE:
+            out._float = a->_float >= b->_float;
+            return true;
+        case OP_LE:
+            out._float = a->_float <= b->_float;
+            return true;
+        case OP_GT:
+            out._float = a->_float > b->_float;
+            return true;
+        case OP_LT:
+            out._float = a->_float < b->_float;
+            return true;
+        case OP_AND:
+            out._float = a->_float && b->_float;
+            return true;
+        case OP_OR:
+            out._float = a->_float || b->_float;
+            return true;
+        case OP_NOT_F:
+            out._float = !a->_float;
+            return true;
+        case OP_NOT_V:
+            out._float = !a->vector[0] && !a->vector[1] && !a->vector[2];
+            return true;
+        case OP_EQ_F:
+            out._float = a->_float == b->_float;
+            return true;
+        case OP_EQ_V:
+            out._float = a->vector == b->vector;
+            return true;
+        case OP_NE_F:
+            out._float = a->_float != b->_float;
+            return true;
+        case OP_NE_V:
+            out._float = a->vector != b->vector;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+============
+PR_FindConstants
+
+A global is constant if no statement writes it, it isn't a system global
+or part of a function's parms and locals, and savegames don't restore it
+============
+*/
+static auto PR_FindConstants() -> std::vector<bool> {
+    std::vector<bool> constant(progs->numglobals, true);
+
+    auto clear = [&constant](int ofs, int width) {
+        for (int i = std::max(ofs, 0); i < ofs + width && i < progs->numglobals; i++)
+            constant[i] = false;
+    };
+
+    clear(0, sizeof(globalvars_t) / 4);
+
+    for (int i = 0; i < progs->numstatements; i++) {
+        int ofs = 0;
+        if (const auto width = PR_Writes(&pr_statements[i], ofs))
+            clear(ofs, width);
+    }
+
+    for (const auto &f : edictFunctions)
+        clear(f.parm_start, f.locals);
+
+    for (int i = 0; i < progs->numglobaldefs; i++) {
+        const auto *def = &pr_globaldefs[i];
+        if (def->type & DEF_SAVEGLOBAL)
+            clear(def->ofs, type_size[def->type & ~DEF_SAVEGLOBAL]);
+    }
+
+    return constant;
+}
+
+/*
+==============================================================================
+
+OPTIMIZATION
+
+==============================================================================
+*/
+
+static auto PR_FusedBranch(int op, bool ifnot) -> unsigned short {
+    const auto fop = [op]() -> int {
+        switch (op) {
+            case OP_EQ_F: return OPX_EQ_F_IF;
+            case OP_NE_F: return OPX_NE_F_IF;
+            case OP_EQ_E: return OPX_EQ_E_IF;
+            case OP_NE_E: return OPX_NE_E_IF;
+            case OP_LE: return OPX_LE_IF;
+            case OP_GE: return OPX_GE_IF;
+            case OP_LT: return OPX_LT_IF;
+            case OP_GT: return OPX_GT_IF;
+            case OP_NOT_F: return OPX_NOT_F_IF;
+            default: return 0;
+        }
+    }();
+
+    if (!fop)
+        return 0;
+    return fop + (ifnot ? 1 : 0);
+}
+
+static constexpr auto PR_IsScalarLoad(int op) -> bool {
+    return op == OP_LOAD_F || op == OP_LOAD_S || op == OP_LOAD_ENT || op == OP_LOAD_FLD || op == OP_LOAD_FNC;
+}
+
+static constexpr auto PR_IsScalarStoreP(int op) -> bool {
+    return op == OP_STOREP_F || op == OP_STOREP_S || op == OP_STOREP_ENT || op == OP_STOREP_FLD
+           || op == OP_STOREP_FNC;
+}
+
+/*
+============
+PR_OptimizeFunction
+
+Folds statements on constants, drops stores to locals that the function
+never reads back, and pairs up statements the interpreter can run as one.
+Statements are only ever dropped or merged with the next one, so jumps
+can be remapped afterwards by statement number.
+============
+*/
+static void PR_OptimizeFunction(const dfunction_t *f, int end, const std::vector<bool> &constant,
+                                std::vector<int> &reads, std::vector<bool> &target, std::vector<stmt_info> &info) {
+    const auto start = f->first_statement;
+    const auto localsEnd = f->parm_start + f->locals;
+    auto isLocal = [f, localsEnd](int ofs, int width) {
+        return ofs >= f->parm_start && ofs + width <= localsEnd;
+    };
+    auto isConstant = [&constant](int ofs, int width) {
+        for (int i = ofs; i < ofs + width; i++)
+            if (i < 0 || i >= progs->numglobals || !constant[i])
+                return false;
+        return true;
+    };
+    auto markReads = [&reads](int ofs, int width, int delta) {
+        for (int i = ofs; i < ofs + width; i++)
+            if (i >= 0 && i < progs->numglobals)
+                reads[i] += delta;
+    };
+
+    for (int s = start; s < end; s++) {
+        const auto *st = &pr_statements[s];
+        if (st->op > OP_BITOR)
+            continue;
+        markReads((unsigned short) st->a, PR_ReadsA(st->op), 1);
+        markReads((unsigned short) st->b, PR_ReadsB(st->op), 1);
+        if (PR_IsJump(st->op)) {
+            const auto t = PR_JumpTarget(st, s);
+            if (t >= start && t < end)
+                target[t] = true;
+        }
+    }
+
+// constant folding
+    for (int s = start; s < end; s++) {
+        const auto *st = &pr_statements[s];
+
+        if (st->op == OP_IF || st->op == OP_IFNOT) {
+            if (!isConstant((unsigned short) st->a, 1))
+                continue;
+            const bool taken = (G_INT((unsigned short) st->a) != 0) == (st->op == OP_IF);
+            info[s].action = taken ? stmt_action::jump : stmt_action::drop;
+            continue;
+        }
+
+        int ofs = 0;
+        if (!PR_Writes(st, ofs) || st->op > OP_BITOR
+            || !isConstant((unsigned short) st->a, PR_ReadsA(st->op))
+            || !isConstant((unsigned short) st->b, PR_ReadsB(st->op)))
+            continue;
+
+        eval_t value{};
+        if (!PR_FoldStatement(st, value))
+            continue;
+
+        info[s].action = stmt_action::fold;
+        info[s].folded = &pr_folded.emplace_back(value);
+    }
+
+// dead store elimination
+    for (int s = start; s < end; s++) {
+        const auto *st = &pr_statements[s];
+        int ofs = 0;
+        const auto width = PR_Writes(st, ofs);
+
+        // OP_ADDRESS stays for its world entity check
+        if (!width || st->op == OP_ADDRESS || st->op > OP_BITOR || info[s].action == stmt_action::drop)
+            continue;
+        if (!isLocal(ofs, width))
+            continue;
+
+        bool read = false;
+        for (int i = ofs; i < ofs + width; i++)
+            read |= reads[i] != 0;
+        if (read)
+            continue;
+
+        info[s].action = stmt_action::drop;
+    }
+
+// statement fusion
+    for (int s = start; s + 1 < end; s++) {
+        const auto *st = &pr_statements[s];
+        const auto *next = &pr_statements[s + 1];
+
+        if (info[s].action != stmt_action::keep || info[s + 1].action != stmt_action::keep || target[s + 1])
+            continue;
+
+        unsigned short fop = 0;
+
+        if (next->op == OP_IF || next->op == OP_IFNOT) {
+            // qcc reuses its temps, so the fused version still stores the
+            // compare result; it just saves the dispatch and reload
+            if (next->a == st->c)
+                fop = PR_FusedBranch(st->op, next->op == OP_IFNOT);
+        } else if (st->op == OP_ADDRESS && next->b == st->c) {
+            if (PR_IsScalarStoreP(next->op))
+                fop = OPX_ADDRESS_STOREP;
+            else if (next->op == OP_STOREP_V)
+                fop = OPX_ADDRESS_STOREP_V;
+        } else if (PR_IsScalarLoad(st->op) && PR_IsScalarLoad(next->op)
+                   && next->a == st->a && st->c != next->a && st->c != next->b) {
+            fop = OPX_LOAD_LOAD;
+        }
+
+        if (!fop)
+            continue;
+
+        info[s].action = stmt_action::fuse;
+        info[s].fop = fop;
+        s++;    // the second half can't start another pair
+    }
+
+    for (int s = start; s < end; s++) {
+        const auto *st = &pr_statements[s];
+        markReads((unsigned short) st->a, PR_ReadsA(st->op), -1);
+        markReads((unsigned short) st->b, PR_ReadsB(st->op), -1);
+        target[s] = false;
+    }
+}
+
+/*
+============
+PR_DecodeStatement
+============
+*/
+static auto PR_DecodeStatement(const dstatement_t *st) -> prstatement_t {
+    prstatement_t ds{};
+
+    ds.op = st->op <= OP_BITOR ? st->op : static_cast<unsigned short>(OPX_BAD);    // anything unknown is a bad opcode
+    ds.fop = ds.op;
+    ds.branch = st->op == OP_GOTO ? st->a : st->b;
+    ds.a = (eval_t *) &pr_globals[st->a];
+    ds.b = (eval_t *) &pr_globals[st->b];
+    ds.c = (eval_t *) &pr_globals[st->c];
+
+    return ds;
+}
+
+/*
+====================
+PR_DecodeStatements
+
+Turns pr_statements into pr_decoded once per progs load, so the
+interpreter doesn't have to turn operand offsets into global pointers
+on every statement it runs, and optimizes it unless pr_optimize is 0.
+pr_codestatement and pr_statementcode map between the two numberings
+for stack traces and function entry.
+====================
+*/
+void PR_DecodeStatements() {
+    const auto numstatements = progs->numstatements;
+    std::vector<stmt_info> info(numstatements);
+
+    pr_folded.clear();
+
+    if (pr_optimize.value) {
+        const auto constant = PR_FindConstants();
+        std::vector<int> reads(progs->numglobals);
+        std::vector<bool> target(numstatements);
+
+        // a function's statements run up to where the next one's start
+        std::vector<const dfunction_t *> functions;
+        for (const auto &f : edictFunctions)
+            if (f.first_statement > 0 && f.first_statement < numstatements)
+                functions.push_back(&f);
+        std::ranges::sort(functions, {}, &dfunction_t::first_statement);
+
+        for (std::size_t i = 0; i < functions.size(); i++) {
+            const auto end = i + 1 < functions.size() ? functions[i + 1]->first_statement : numstatements;
+            PR_OptimizeFunction(functions[i], end, constant, reads, target, info);
+        }
+    }
+
+    pr_decoded.clear();
+    pr_decoded.reserve(numstatements);
+    pr_codestatement.clear();
+    pr_codestatement.reserve(numstatements);
+    pr_statementcode.resize(numstatements + 1);
+
+    for (int s = 0; s < numstatements; s++) {
+        const auto *st = &pr_statements[s];
+        pr_statementcode[s] = static_cast<int>(pr_decoded.size());
+
+        auto ds = PR_DecodeStatement(st);
+        switch (info[s].action) {
+            case stmt_action::drop:
+                continue;
+            case stmt_action::fold: {
+                int ofs = 0;
+                ds.op = ds.fop = PR_Writes(st, ofs) == 3 ? OP_STORE_V : OP_STORE_F;
+                ds.a = info[s].folded;
+                ds.b = (eval_t *) &pr_globals[ofs];
+                break;
+            }
+            case stmt_action::jump:
+                ds.op = ds.fop = OP_GOTO;
+                break;
+            case stmt_action::fuse:
+                ds.fop = info[s].fop;
+                break;
+            case stmt_action::keep:
+                break;
+        }
+
+        pr_decoded.push_back(ds);
+        pr_codestatement.push_back(s);
+    }
+    pr_statementcode[numstatements] = static_cast<int>(pr_decoded.size());
+
+// point the jumps at the renumbered statements
+    for (std::size_t i = 0; i < pr_decoded.size(); i++) {
+        auto *ds = &pr_decoded[i];
+        const auto s = pr_codestatement[i];
+
+        if (!PR_IsJump(ds->op))
+            continue;
+
+        const auto t = PR_JumpTarget(&pr_statements[s], s);
+        if (t < 0 || t >= numstatements)
+            continue;    // left as is, it was never a valid jump
+        ds->branch = pr_statementcode[t] - static_cast<int>(i);
+    }
+
+    Con_DPrintf("%i progs statements, %i after optimization\n", numstatements, pr_decoded.size());
+}
@@ -0,0 +1,225 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// pr_prof.cpp -- wall clock profiling of QC functions and builtins
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include "util.hpp"
+
+// 0 is off, 1 times every top level call into the progs, N times one in N
+cvar_t pr_profile = {"pr_profile", "0"};
+
+qboolean pr_profiling;
+
+using proftime_t = std::int64_t;    // nanoseconds
+
+// a function at one place in the call tree
+using profnode_t = struct {
+    int function;
+    int parent;
+    proftime_t self;
+};
+
+using proffunction_t = struct {
+    proftime_t inclusive;
+    proftime_t exclusive;
+    std::int64_t calls;
+    int active;        // calls on the stack, so recursion isn't counted twice
+};
+
+using profframe_t = struct {
+    int node;
+    proftime_t start;
+    proftime_t children;
+};
+
+static std::vector<profnode_t> prof_nodes;
+static std::unordered_map<std::uint64_t, int> prof_children;
+static std::vector<proffunction_t> prof_functions;
+static std::vector<profframe_t> prof_frames;
+static unsigned prof_toplevel;
+
+static auto PR_ProfileTime() -> proftime_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// entry points run through the copies in edictFunctions, calls through
+// pr_functions
+static auto PR_ProfileFunctionNumber(const dfunction_t *f) -> int {
+    if (!edictFunctions.empty() && f >= edictFunctions.data() && f < edictFunctions.data() + edictFunctions.size())
+        return static_cast<int>(f - edictFunctions.data());
+    return static_cast<int>(f - pr_functions);
+}
+
+/*
+============
+PR_ProfileStart
+
+Called for every top level PR_ExecuteProgram. Drops whatever an aborted
+function left on the stack and decides whether this call is timed.
+============
+*/
+void PR_ProfileStart() {
+    if (!prof_frames.empty()) {
+        prof_frames.clear();
+        for (auto &func: prof_functions)
+            func.active = 0;
+    }
+
+    const auto every = static_cast<unsigned>(pr_profile.value);
+    pr_profiling = every && prof_functions.size() == static_cast<std::size_t>(progs->numfunctions)
+                   && ++prof_toplevel % every == 0;
+}
+
+/*
+============
+PR_ProfileEnter
+
+f is a QC function or a builtin about to run
+============
+*/
+void PR_ProfileEnter(const dfunction_t *f) {
+    const auto function = PR_ProfileFunctionNumber(f);
+    const auto parent = prof_frames.empty() ? -1 : prof_frames.back().node;
+    const auto key = static_cast<std::uint64_t>(static_cast<unsigned>(parent)) << 32 | static_cast<unsigned>(function);
+
+    const auto [it, added] = prof_children.try_emplace(key, static_cast<int>(prof_nodes.size()));
+    if (added)
+        prof_nodes.push_back({function, parent, 0});
+
+    prof_functions[function].active++;
+    prof_frames.push_back({it->second, PR_ProfileTime(), 0});
+}
+
+/*
+============
+PR_ProfileLeave
+============
+*/
+void PR_ProfileLeave() {
+    if (prof_frames.empty())
+        return;
+
+    const auto frame = prof_frames.back();
+    prof_frames.pop_back();
+
+    const auto total = PR_ProfileTime() - frame.start;
+    auto *node = &prof_nodes[frame.node];
+    auto *func = &prof_functions[node->function];
+
+    node->self += total - frame.children;
+    func->exclusive += total - frame.children;
+    func->calls++;
+    if (!--func->active)
+        func->inclusive += total;
+
+    if (!prof_frames.empty())
+        prof_frames.back().children += total;
+}
+
+/*
+============
+PR_ProfileClear
+
+Throws away everything recorded, and sizes the tables for the current
+progs
+============
+*/
+void PR_ProfileClear() {
+    prof_nodes.clear();
+    prof_children.clear();
+    prof_frames.clear();
+    prof_functions.assign(progs ? progs->numfunctions : 0, {});
+}
+
+/*
+============
+PR_ProfileTime_f
+
+Prints the functions that took the most time themselves
+============
+*/
+void PR_ProfileTime_f() {
+    std::vector<int> order;
+
+    for (std::size_t i = 0; i < prof_functions.size(); i++) {
+        if (prof_functions[i].calls)
+            order.push_back(static_cast<int>(i));
+    }
+    std::sort(order.begin(), order.end(), [](int a, int b) {
+        return prof_functions[a].exclusive > prof_functions[b].exclusive;
+    });
+
+    Con_Printf("   self ms   total ms     calls\n");
+    for (std::size_t i = 0; i < order.size() && i < 10; i++) {
+        const auto *func = &prof_functions[order[i]];
+        Con_Printf("%10.3f %10.3f %9i %s\n", func->exclusive / 1e6, func->inclusive / 1e6,
+                   static_cast<int>(func->calls), getStringByOffset(pr_functions[order[i]].s_name).data());
+    }
+}
+
+/*
+============
+PR_ProfileDump_f
+
+Writes the call tree in the collapsed stack format flamegraph tools read,
+one line per call path with the microseconds spent in its last function
+============
+*/
+void PR_ProfileDump_f() {
+    if (Cmd_Argc() != 2) {
+        Con_Printf("profile_dump <file> : write the QC call stacks for flamegraph tools\n");
+        return;
+    }
+
+    const auto name = va("%s/%s", com_gamedir, Cmd_Argv(1));
+    auto f = fopen(name.c_str(), "w");
+    if (!f) {
+        Con_Printf("Couldn't write %s.\n", name);
+        return;
+    }
+
+    std::vector<int> path;
+    for (const auto &node: prof_nodes) {
+        const auto usec = node.self / 1000;
+        if (usec <= 0)
+            continue;
+
+        path.clear();
+        for (auto *n = &node;; n = &prof_nodes[n->parent]) {
+            path.push_back(n->function);
+            if (n->parent < 0)
+                break;
+        }
+
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            if (it != path.rbegin())
+                fputc(';', f);
+            fputs(getStringByOffset(pr_functions[*it].s_name).data(), f);
+        }
+        fprintf(f, " %lld\n", static_cast<long long>(usec));
+    }
+
+    fclose(f);
+    Con_Printf("Wrote %s.\n", name);
+}
@@ -41,7 +41,8 @@ typedef union eval_s {
 #define    MAX_ENT_LEAFS    16
 typedef struct edict_s {
     qboolean free;
-    link_t area;                // linked to a division node or leaf
+    struct arealist_s *arealist;    // area node list it is linked into, NULL if none
+    int areaslot;                // index in arealist
 
     int num_leafs;
     short leafnums[MAX_ENT_LEAFS];
@@ -53,8 +54,6 @@ typedef struct edict_s {
 // other fields from progs come immediately after
 } edict_t;
 
-#define    EDICT_FROM_AREA(l) STRUCT_FROM_LINK(l,edict_t,area)
-
 //============================================================================
 
 extern dprograms_t *progs;
@@ -68,11 +67,85 @@ extern float *pr_globals;            // same as pr_global_struct
 
 extern int pr_edict_size;    // in bytes
 
+// pr_strings is a hunk arena: the progs string lump followed by the strings
+// created at runtime, so a string_t is always a plain offset into it
+constexpr auto PR_DYNAMIC_STRING_SPACE = 256 * 1024;
+extern int pr_stringssize;    // bytes in use
+extern int pr_maxstrings;
+
 // maybe mapping strings to functions would be good
-extern std::map<unsigned, std::string> edictStrings;
 extern std::vector<dfunction_t> edictFunctions;
 
-extern std::size_t staticStringCount;
+//============================================================================
+
+// engine private opcodes, only ever found in pr_decoded
+enum {
+    OPX_BAD = OP_BITOR + 1,
+
+    // compare + OP_IF/OP_IFNOT on the result, which nothing else reads
+    OPX_EQ_F_IF, OPX_EQ_F_IFNOT,
+    OPX_NE_F_IF, OPX_NE_F_IFNOT,
+    OPX_EQ_E_IF, OPX_EQ_E_IFNOT,
+    OPX_NE_E_IF, OPX_NE_E_IFNOT,
+    OPX_LE_IF, OPX_LE_IFNOT,
+    OPX_GE_IF, OPX_GE_IFNOT,
+    OPX_LT_IF, OPX_LT_IFNOT,
+    OPX_GT_IF, OPX_GT_IFNOT,
+    OPX_NOT_F_IF, OPX_NOT_F_IFNOT,
+
+    OPX_ADDRESS_STOREP,        // OP_ADDRESS + OP_STOREP_F/S/ENT/FLD/FNC through it
+    OPX_ADDRESS_STOREP_V,
+    OPX_LOAD_LOAD,            // two non-vector OP_LOAD_* from the same entity
+
+    OPX_NUMOPS
+};
+
+// a statement with its operands resolved to globals. Fused statements keep
+// the second half in the following slot, so the plain op of every slot can
+// still be run on its own.
+typedef struct prstatement_s {
+    unsigned short op;        // plain opcode
+    unsigned short fop;        // opcode to run when fused statements are allowed
+    int branch;                // jump offset for OP_IF, OP_IFNOT and OP_GOTO
+    eval_t *a, *b, *c;
+} prstatement_t;
+
+extern std::vector<prstatement_t> pr_decoded;
+extern std::vector<int> pr_codestatement;    // pr_decoded index -> pr_statements index
+extern std::vector<int> pr_statementcode;    // pr_statements index -> pr_decoded index
+
+extern cvar_t pr_optimize;
+
+void PR_DecodeStatements();
+
+extern qboolean pr_jit;
+
+void PR_JitInit();
+
+void PR_JitReset();
+
+void PR_JitExecute(func_t fnum);
+
+void PR_RunFunction(dfunction_t *f);
+
+auto PR_EnterFunction(dfunction_t *f) -> int;
+
+auto PR_LeaveFunction() -> int;
+
+extern cvar_t pr_profile;
+extern qboolean pr_profiling;
+
+void PR_ProfileStart();
+
+void PR_ProfileEnter(const dfunction_t *f);
+
+void PR_ProfileLeave();
+
+void PR_ProfileClear();
+
+void PR_ProfileTime_f();
+
+void PR_ProfileDump_f();
 
 //============================================================================
 
@@ -122,6 +195,57 @@ auto G_STRING(int o) -> const char *;
 
 //============================================================================
 
+// The fields the engine scans every edict for, copied out side by side so
+// the scans read arrays instead of striding through whole edicts. Anything
+// that writes one of them marks the edict with ED_CHANGED, and ED_SyncHot
+// brings the copies of marked edicts up to date before they are read.
+typedef struct edhot_s {
+    std::vector<byte> free;
+    std::vector<float> movetype;
+    std::vector<float> solid;
+    std::vector<float> flags;
+    std::vector<float> nextthink;
+    std::vector<byte> visible;        // has a model to send to clients
+    std::vector<vec3> center;        // origin + the middle of mins and maxs
+    std::vector<byte> numleafs;
+    std::vector<short> leafnums;    // MAX_ENT_LEAFS for each edict
+    std::vector<int> strayslot;        // in ed_strays, -1 if not there
+} edhot_t;
+
+extern edhot_t ed_hot;
+
+// solid edicts the area tree can't be trusted to find by their centre: not
+// linked, or moved outside the box they were linked with
+extern std::vector<int> ed_strays;
+
+// one byte for each edict, by its offset in sv.edicts shifted down, which
+// is cheap enough for every QC field store. Edicts are bigger than
+// 1 << ED_CHANGED_SHIFT bytes, so no two share a byte.
+//
+// SV_Physics only visits edicts that have been marked, or synced since it
+// last looked at them, or whose think has come due: ED_WakeThinks at the
+// start of the frame and ED_NextPending to walk them.
+#define    ED_CHANGED_SHIFT    6
+extern byte *ed_changed;
+
+#define    ED_CHANGED(e) (ed_changed[EDICT_TO_PROG(e) >> ED_CHANGED_SHIFT] = 1)
+
+void ED_ResetHot();
+
+void ED_SyncHot(int num);
+
+void ED_SyncHot();
+
+void ED_WakeThinks(double deadline);
+
+auto ED_NextPending(int num) -> int;
+
+auto ED_FindIndexed(int start, int field, std::string_view s) -> int;
+// the first edict after start whose string field matches s, 0 if there
+// isn't one, or -1 if the field isn't indexed
+
+//============================================================================
+
 #define    G_FLOAT(o) (pr_globals[o])
 #define    G_INT(o) (*(int *)&pr_globals[o])
 #define    G_EDICT(o) ((edict_t *)((byte *)sv.edicts + *(int *)&pr_globals[o])) // FIXME
@@ -149,6 +273,7 @@ extern const int pr_numbuiltins;
 extern int pr_argc;
 
 extern qboolean pr_trace;
+extern cvar_t pr_fastexec;
 extern dfunction_t *pr_xfunction;
 extern int pr_xstatement;
 
@@ -160,6 +285,21 @@ void ED_PrintEdicts();
 
 void ED_PrintNum(int ent);
 
+auto ED_FindFieldOffset(std::string_view name) -> int;
+
+eval_t *GetEdictFieldValue(edict_t *ed, int fieldoffset);
+
 eval_t *GetEdictFieldValue(edict_t *ed, std::string_view field);
 
+// offsets of fields that only some progs define, see ED_FindFieldOffset
+extern int eval_gravity;
+extern int eval_items2;
+extern int eval_ammo_shells1;
+extern int eval_ammo_nails1;
+extern int eval_ammo_lava_nails;
+extern int eval_ammo_rockets1;
+extern int eval_ammo_multi_rockets;
+extern int eval_ammo_cells1;
+extern int eval_ammo_plasma;
+
 #endif
\ No newline at end of file
@@ -21,6 +21,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define    PROTOCOL_VERSION    15
 
+// PROTOCOL_VERSION with entity updates delta compressed against the last
+// frame the client acknowledged. Clients announce it in their connection
+// request and the server picks it in svc_serverinfo.
+#define    PROTOCOL_DELTA        16
+
+// frames of sent entity states kept for delta compression, must be a
+// power of two
+#define    UPDATE_BACKUP    64
+#define    UPDATE_MASK        (UPDATE_BACKUP - 1)
+
 // if the high bit of the servercmd is set, the low bits are fast update flags:
 #define    U_MOREBITS    (1<<0)
 #define    U_ORIGIN1    (1<<1)
@@ -130,13 +140,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define svc_cutscene        34
 
+#define svc_entityframe        35    // [long] frame [byte] frames back to delta from, 0 for the baselines
+                                    // PROTOCOL_DELTA only, ahead of the frame's updates
+
 //
 // client to server
 //
 #define    clc_bad            0
 #define    clc_nop        1
 #define    clc_disconnect    2
-#define    clc_move        3            // [usercmd_t]
+#define    clc_move        3            // [usercmd_t], then [long] last svc_entityframe with PROTOCOL_DELTA
 #define    clc_stringcmd    4        // [string] message
 
 
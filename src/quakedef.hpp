@@ -255,6 +255,8 @@ void	VID_UnlockBuffer ();
 #include "view.hpp"
 #include "menu.hpp"
 #include "crc.hpp"
+#include "bitset.hpp"
+#include "thread.hpp"
 
 #ifdef GLQUAKE
 #include "glquake.hpp"
@@ -106,8 +106,6 @@ int reinit_surfcache = 1;    // if 1, surface cache is currently empty and
 
 mleaf_t *r_viewleaf, *r_oldviewleaf;
 
-texture_t *r_notexture_mip;
-
 float r_aliastransition, r_resfudge;
 
 int d_lightstylevalue[256];    // 8.8 fraction of base light value
@@ -145,37 +143,6 @@ void CreatePassages();
 
 void SetVisibilityByPassages();
 
-/*
-==================
-R_InitTextures
-==================
-*/
-void R_InitTextures() {
-    int x = 0, y = 0, m = 0;
-    byte *dest = nullptr;
-
-// create a simple checkerboard texture for the default
-    r_notexture_mip = hunkAllocName<decltype(r_notexture_mip)>(sizeof(texture_t) + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2,
-                                                               "notexture");
-
-    r_notexture_mip->width = r_notexture_mip->height = 16;
-    r_notexture_mip->offsets[0] = sizeof(texture_t);
-    r_notexture_mip->offsets[1] = r_notexture_mip->offsets[0] + 16 * 16;
-    r_notexture_mip->offsets[2] = r_notexture_mip->offsets[1] + 8 * 8;
-    r_notexture_mip->offsets[3] = r_notexture_mip->offsets[2] + 4 * 4;
-
-    for (m = 0; m < 4; m++) {
-        dest = (byte *) r_notexture_mip + r_notexture_mip->offsets[m];
-        for (y = 0; y < (16 >> m); y++)
-            for (x = 0; x < (16 >> m); x++) {
-                if ((y < (8 >> m)) ^ (x < (8 >> m)))
-                    *dest++ = 0;
-                else
-                    *dest++ = 0xff;
-            }
-    }
-}
-
 /*
 ===============
 R_Init
@@ -475,29 +442,23 @@ R_MarkLeaves
 ===============
 */
 void R_MarkLeaves() {
-    byte *vis = nullptr;
-    mnode_t *node = nullptr;
-    int i = 0;
-
     if (r_oldviewleaf == r_viewleaf)
         return;
 
     r_visframecount++;
     r_oldviewleaf = r_viewleaf;
 
-    vis = Mod_LeafPVS(r_viewleaf, cl.worldmodel);
-
-    for (i = 0; i < cl.worldmodel->numleafs; i++) {
-        if (vis[i >> 3] & (1 << (i & 7))) {
-            node = (mnode_t *) &cl.worldmodel->leafs[i + 1];
-            do {
-                if (node->visframe == r_visframecount)
-                    break;
-                node->visframe = r_visframecount;
-                node = node->parent;
-            } while (node);
-        }
-    }
+    const auto *vis = Mod_LeafPVS(r_viewleaf, cl.worldmodel);
+
+    Bits_ForEachSet(vis, cl.worldmodel->numleafs, [](int i) {
+        auto *node = (mnode_t *) &cl.worldmodel->leafs[i + 1];
+        do {
+            if (node->visframe == r_visframecount)
+                break;
+            node->visframe = r_visframecount;
+            node = node->parent;
+        } while (node);
+    });
 }
 
 
@@ -108,6 +108,10 @@ using client_t = struct client_s {
 
 // client known data for deltas
     int old_frags;
+
+    int protocol;            // PROTOCOL_VERSION or PROTOCOL_DELTA
+    int entityframe;        // last svc_entityframe sent
+    int ackframe;            // last one the client acknowledged, 0 for none
 };
 
 
@@ -260,6 +264,18 @@ void SV_RunClients();
 
 void SV_SaveSpawnparms();
 
+extern cvar_t sv_phs;
+
+void SV_BuildVis();
+
+auto SV_LeafPVS(struct mleaf_s *leaf) -> const byte *;
+
+auto SV_LeafPHS(struct mleaf_s *leaf) -> const byte *;
+
+auto SV_FatPVS(vec3 org, int clientnum) -> const byte *;
+
+auto SV_CanHear(vec3 org) -> bool;
+
 #ifdef QUAKE2
 void SV_SpawnServer (char *server, char *startspot);
 #else
@@ -0,0 +1,62 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// snd_null.cpp -- sound stubs for the dedicated server
+
+#include "quakedef.hpp"
+
+void S_Init() {
+}
+
+void S_Shutdown() {
+}
+
+void S_StartSound(int entnum, int entchannel, sfx_t *sfx, vec3 origin, float fvol, float attenuation) {
+}
+
+void S_StaticSound(sfx_t *sfx, vec3 origin, float vol, float attenuation) {
+}
+
+void S_StopSound(int entnum, int entchannel) {
+}
+
+void S_StopAllSounds(qboolean clear) {
+}
+
+void S_Update(vec3 origin, vec3 v_forward, vec3 v_right, vec3 v_up) {
+}
+
+void S_ExtraUpdate() {
+}
+
+auto S_PrecacheSound(std::string_view sample) -> sfx_t * {
+    return nullptr;
+}
+
+void S_TouchSound(char *sample) {
+}
+
+void S_BeginPrecaching() {
+}
+
+void S_EndPrecaching() {
+}
+
+void S_LocalSound(std::string_view s) {
+}
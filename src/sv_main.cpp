@@ -29,6 +29,9 @@ server_static_t svs;
 
 char localmodels[MAX_MODELS][5];            // inline model names for precache
 
+// use PROTOCOL_DELTA with clients that understand it
+cvar_t sv_delta = {"sv_delta", "1"};
+
 //============================================================================
 
 /*
@@ -48,6 +51,9 @@ void SV_Init() {
     extern cvar_t sv_accelerate;
     extern cvar_t sv_idealpitchscale;
     extern cvar_t sv_aim;
+    extern cvar_t sv_areadepth;
+    extern cvar_t sv_touchonce;
+    extern cvar_t sv_parallelphysics;
 
     Cvar_RegisterVariable(&sv_maxvelocity);
     Cvar_RegisterVariable(&sv_gravity);
@@ -59,6 +65,11 @@ void SV_Init() {
     Cvar_RegisterVariable(&sv_idealpitchscale);
     Cvar_RegisterVariable(&sv_aim);
     Cvar_RegisterVariable(&sv_nostep);
+    Cvar_RegisterVariable(&sv_phs);
+    Cvar_RegisterVariable(&sv_delta);
+    Cvar_RegisterVariable(&sv_areadepth);
+    Cvar_RegisterVariable(&sv_touchonce);
+    Cvar_RegisterVariable(&sv_parallelphysics);
 
     for (i = 0; i < MAX_MODELS; i++)
         sprintf(localmodels[i], "*%i", i);
@@ -146,6 +157,11 @@ void SV_StartSound(edict_t *entity, int channel, std::string_view sample, int vo
 
     ent = NUM_FOR_EDICT(entity);
 
+// nobody out of earshot gets it anyway, unless it's meant for everyone
+    const vec3 origin = entity->v.origin + 0.5F * (entity->v.mins + entity->v.maxs);
+    if (sv_phs.value && attenuation != 0 && !SV_CanHear(origin))
+        return;
+
     channel = (ent << 3) | channel;
 
     field_mask = 0;
@@ -163,7 +179,7 @@ void SV_StartSound(edict_t *entity, int channel, std::string_view sample, int vo
         MSG_WriteByte(&sv.datagram, attenuation * 64);
     MSG_WriteShort(&sv.datagram, channel);
     MSG_WriteByte(&sv.datagram, sound_num);
-    MSG_WriteCoords(&sv.datagram, entity->v.origin + 0.5F * (entity->v.mins + entity->v.maxs));
+    MSG_WriteCoords(&sv.datagram, origin);
 }
 
 /*
@@ -174,6 +190,76 @@ CLIENT SPAWNING
 ==============================================================================
 */
 
+/*
+==============================================================================
+
+With PROTOCOL_DELTA every frame of entity updates a client is sent is
+numbered, and the client acknowledges the last one it got in each move.
+Updates are compressed against the state the client holds for the entity
+in that frame, so the server keeps what it sent in the last UPDATE_BACKUP
+frames for each client.
+
+==============================================================================
+*/
+
+using svframeentity_t = struct {
+    int num;
+    entity_state_t state;        // as the client reads it back
+};
+
+using svframe_t = struct {
+    int sequence;
+    std::vector<svframeentity_t> entities;        // in entity number order
+};
+
+static std::vector<std::array<svframe_t, UPDATE_BACKUP>> sv_frames;
+
+static void SV_ClearFrames(int clientnum) {
+    if (clientnum >= static_cast<int>(sv_frames.size()))
+        sv_frames.resize(clientnum + 1);
+
+    for (auto &frame: sv_frames[clientnum]) {
+        frame.sequence = 0;
+        frame.entities.clear();
+    }
+}
+
+/*
+================
+SV_QuantizedState
+
+An entity's state the way the client will decode it. Entities take their
+current values, the baseline is what svc_spawnbaseline sent.
+================
+*/
+static auto SV_QuantizedState(const edict_t *ent, qboolean baseline) -> entity_state_t {
+    entity_state_t state;
+
+    if (baseline) {
+        for (int i = 0; i < 3; i++) {
+            state.origin[i] = MSG_RoundCoord(ent->baseline.origin[i]);
+            state.angles[i] = MSG_RoundAngle(ent->baseline.angles[i]);
+        }
+        state.modelindex = ent->baseline.modelindex & 255;
+        state.frame = ent->baseline.frame & 255;
+        state.colormap = ent->baseline.colormap & 255;
+        state.skin = ent->baseline.skin & 255;
+        state.effects = 0;        // never sent
+        return state;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        state.origin[i] = MSG_RoundCoord(ent->v.origin[i]);
+        state.angles[i] = MSG_RoundAngle(ent->v.angles[i]);
+    }
+    state.modelindex = static_cast<int>(ent->v.modelindex) & 255;
+    state.frame = static_cast<int>(ent->v.frame) & 255;
+    state.colormap = static_cast<int>(ent->v.colormap) & 255;
+    state.skin = static_cast<int>(ent->v.skin) & 255;
+    state.effects = static_cast<int>(ent->v.effects) & 255;
+    return state;
+}
+
 /*
 ================
 SV_SendServerinfo
@@ -190,8 +276,15 @@ void SV_SendServerinfo(client_t *client) {
     sprintf(message, "%c\nVERSION %4.2f SERVER (%i CRC)", 2, VERSION, pr_crc);
     MSG_WriteString(&client->message, message);
 
+    if (sv_delta.value && client->netconnection->protocol >= PROTOCOL_DELTA)
+        client->protocol = PROTOCOL_DELTA;
+    else
+        client->protocol = PROTOCOL_VERSION;
+    client->ackframe = 0;
+    SV_ClearFrames(static_cast<int>(client - svs.clients));
+
     MSG_WriteByte(&client->message, svc_serverinfo);
-    MSG_WriteLong(&client->message, PROTOCOL_VERSION);
+    MSG_WriteLong(&client->message, client->protocol);
     MSG_WriteByte(&client->message, svs.maxclients);
 
     if (!coop.value && deathmatch.value)
@@ -326,59 +419,6 @@ void SV_ClearDatagram() {
     SZ_Clear(&sv.datagram);
 }
 
-/*
-=============================================================================
-
-The PVS must include a small area around the client to allow head bobbing
-or other small motion on the client side.  Otherwise, a bob might cause an
-entity that should be visible to not show up, especially when the bob
-crosses a waterline.
-
-=============================================================================
-*/
-
-static std::array<byte, MAX_MAP_LEAFS / 8> fatpvs{};
-
-void SV_AddToFatPVS(const vec3 org, mnode_t *node, const auto fatbytes) {
-    while (true) {
-        // if this is a leaf, accumulate the pvs bits
-        if (node->contents < 0) {
-            if (node->contents != CONTENTS_SOLID) {
-                const auto *pvs = Mod_LeafPVS(reinterpret_cast<mleaf_t *>(node), sv.worldmodel);
-                for (int i = 0; i < fatbytes; i++)
-                    fatpvs[i] |= pvs[i];
-            }
-            return;
-        }
-
-        const auto *plane = node->plane;
-        const auto d = glm::dot(org, plane->normal) - plane->dist;
-        if (d > 8)
-            node = node->children[0];
-        else if (d < -8)
-            node = node->children[1];
-        else {    // go down both
-            SV_AddToFatPVS(org, node->children[0], fatbytes);
-            node = node->children[1];
-        }
-    }
-}
-
-/*
-=============
-SV_FatPVS
-
-Calculates a PVS that is the inclusive or of all leafs within 8 pixels of the
-given point.
-=============
-*/
-inline auto SV_FatPVS(const vec3 org) {
-    const auto fatbytes = static_cast<unsigned>(sv.worldmodel->numleafs + 31) >> 3U;
-    memset(fatpvs.data(), 0, fatbytes);
-    SV_AddToFatPVS(org, sv.worldmodel->nodes, fatbytes);
-    return fatpvs.begin();
-}
-
 //=============================================================================
 
 
@@ -386,14 +426,41 @@ inline auto SV_FatPVS(const vec3 org) {
 =============
 SV_WriteEntitiesToClient
 
+Returns false if some entities didn't fit
 =============
 */
-void SV_WriteEntitiesToClient(edict_t *clent, sizebuf_t *msg) {
+auto SV_WriteEntitiesToClient(edict_t *clent, sizebuf_t *msg) -> qboolean {
     vec3 org;
+    const auto clientnum = NUM_FOR_EDICT(clent) - 1;
+    auto *client = svs.clients + clientnum;
+    svframe_t *frame = nullptr;
+    const svframe_t *deltaframe = nullptr;
+    std::size_t deltanext = 0;
 
 // find the client's PVS
     org = clent->v.origin + clent->v.view_ofs;
-    const auto *pvs = SV_FatPVS(org);
+    const auto *pvs = SV_FatPVS(org, clientnum);
+
+// number the frame, and compress against the last one the client has
+    if (client->protocol == PROTOCOL_DELTA) {
+        auto &frames = sv_frames[clientnum];
+        const auto sequence = ++client->entityframe;
+        const auto ack = client->ackframe;
+        int back = 0;
+
+        if (ack && sequence - ack < UPDATE_BACKUP && frames[ack & UPDATE_MASK].sequence == ack) {
+            deltaframe = &frames[ack & UPDATE_MASK];
+            back = sequence - ack;
+        }
+
+        frame = &frames[sequence & UPDATE_MASK];
+        frame->sequence = sequence;
+        frame->entities.clear();
+
+        MSG_WriteByte(msg, svc_entityframe);
+        MSG_WriteLong(msg, sequence);
+        MSG_WriteByte(msg, back);
+    }
 
 // send over all entities (excpet the client) that touch the pvs
     const auto *ent = NEXT_EDICT(sv.edicts);
@@ -408,58 +475,101 @@ void SV_WriteEntitiesToClient(edict_t *clent, sizebuf_t *msg) {
         if (ent != clent)    // clent is ALLWAYS sent
         {
 // ignore ents without visible models
-            if (!ent->v.modelindex || !stringExistsAtOffset(ent->v.model))
+            if (!ed_hot.visible[e])
                 continue;
 
-            int i = 0;
-            for (; i < ent->num_leafs; i++)
-                if (pvs[ent->leafnums[i] >> 3] & (1 << (ent->leafnums[i] & 7)))
-                    break;
-
-            if (i == ent->num_leafs)
+            if (!Bits_TestAny(pvs, &ed_hot.leafnums[e * MAX_ENT_LEAFS], ed_hot.numleafs[e]))
                 continue;        // not visible
         }
 
-        if (msg->maxsize - msg->cursize < 16) {
-            Con_Printf("packet overflow\n");
-            return;
-        }
+        if (msg->maxsize - msg->cursize < 16)
+            return false;
 
 // send an update
         int bits = 0;
 
-        for (int i = 0; i < 3; i++) {
-            const auto miss = ent->v.origin[i] - ent->baseline.origin[i];
-            if (miss < -0.1 || miss > 0.1)
-                bits |= U_ORIGIN1 << i;
-        }
+        if (frame) {
+            // against what the client holds, compared the way it will read them
+            const auto to = SV_QuantizedState(ent, false);
+            entity_state_t baseline;
+            const entity_state_t *from = nullptr;
+
+            if (deltaframe) {
+                const auto &entities = deltaframe->entities;
+                while (deltanext < entities.size() && entities[deltanext].num < e)
+                    deltanext++;
+                if (deltanext < entities.size() && entities[deltanext].num == e)
+                    from = &entities[deltanext].state;
+            }
+            if (!from) {
+                baseline = SV_QuantizedState(ent, true);
+                from = &baseline;
+            }
 
-        if (ent->v.angles[0] != ent->baseline.angles[0])
-            bits |= U_ANGLE1;
+            for (int i = 0; i < 3; i++) {
+                if (to.origin[i] != from->origin[i])
+                    bits |= U_ORIGIN1 << i;
+            }
 
-        if (ent->v.angles[1] != ent->baseline.angles[1])
-            bits |= U_ANGLE2;
+            if (to.angles[0] != from->angles[0])
+                bits |= U_ANGLE1;
 
-        if (ent->v.angles[2] != ent->baseline.angles[2])
-            bits |= U_ANGLE3;
+            if (to.angles[1] != from->angles[1])
+                bits |= U_ANGLE2;
 
-        if (ent->v.movetype == MOVETYPE_STEP)
-            bits |= U_NOLERP;    // don't mess up the step animation
+            if (to.angles[2] != from->angles[2])
+                bits |= U_ANGLE3;
+
+            if (to.colormap != from->colormap)
+                bits |= U_COLORMAP;
+
+            if (to.skin != from->skin)
+                bits |= U_SKIN;
+
+            if (to.frame != from->frame)
+                bits |= U_FRAME;
+
+            if (to.effects != from->effects)
+                bits |= U_EFFECTS;
+
+            if (to.modelindex != from->modelindex)
+                bits |= U_MODEL;
+
+            frame->entities.push_back({e, to});
+        } else {
+            for (int i = 0; i < 3; i++) {
+                const auto miss = ent->v.origin[i] - ent->baseline.origin[i];
+                if (miss < -0.1 || miss > 0.1)
+                    bits |= U_ORIGIN1 << i;
+            }
 
-        if (ent->baseline.colormap != ent->v.colormap)
-            bits |= U_COLORMAP;
+            if (ent->v.angles[0] != ent->baseline.angles[0])
+                bits |= U_ANGLE1;
 
-        if (ent->baseline.skin != ent->v.skin)
-            bits |= U_SKIN;
+            if (ent->v.angles[1] != ent->baseline.angles[1])
+                bits |= U_ANGLE2;
 
-        if (ent->baseline.frame != ent->v.frame)
-            bits |= U_FRAME;
+            if (ent->v.angles[2] != ent->baseline.angles[2])
+                bits |= U_ANGLE3;
 
-        if (ent->baseline.effects != ent->v.effects)
-            bits |= U_EFFECTS;
+            if (ent->baseline.colormap != ent->v.colormap)
+                bits |= U_COLORMAP;
 
-        if (ent->baseline.modelindex != ent->v.modelindex)
-            bits |= U_MODEL;
+            if (ent->baseline.skin != ent->v.skin)
+                bits |= U_SKIN;
+
+            if (ent->baseline.frame != ent->v.frame)
+                bits |= U_FRAME;
+
+            if (ent->baseline.effects != ent->v.effects)
+                bits |= U_EFFECTS;
+
+            if (ent->baseline.modelindex != ent->v.modelindex)
+                bits |= U_MODEL;
+        }
+
+        if (ent->v.movetype == MOVETYPE_STEP)
+            bits |= U_NOLERP;    // don't mess up the step animation
 
         if (e >= 256)
             bits |= U_LONGENTITY;
@@ -502,6 +612,8 @@ void SV_WriteEntitiesToClient(edict_t *clent, sizebuf_t *msg) {
         if (bits & U_ANGLE3)
             MSG_WriteAngle(msg, ent->v.angles[2]);
     }
+
+    return true;
 }
 
 /*
@@ -521,6 +633,7 @@ void SV_CleanupEnts() {
 ==================
 SV_WriteClientdataToMessage
 
+The caller runs SV_SetIdealPitch first
 ==================
 */
 void SV_WriteClientdataToMessage(edict_t *ent, sizebuf_t *msg) {
@@ -538,11 +651,6 @@ void SV_WriteClientdataToMessage(edict_t *ent, sizebuf_t *msg) {
         ent->v.dmg_save = 0;
     }
 
-//
-// send the current viewpos offset from the view entity
-//
-    SV_SetIdealPitch();        // how much to look up / down ideally
-
 // a fixangle might get lost in a dropped packet.  Oh well.
     if (ent->v.fixangle) {
         MSG_WriteByte(msg, svc_setangle);
@@ -564,7 +672,7 @@ void SV_WriteClientdataToMessage(edict_t *ent, sizebuf_t *msg) {
     items = (int)ent->v.items | ((int)ent->v.items2 << 23);
 #else
   auto get_items = [ent]() {
-    const auto *val = GetEdictFieldValue(ent, "items2");
+    const auto *val = GetEdictFieldValue(ent, eval_items2);
 
     if (val != nullptr)
       return (unsigned) ent->v.items | ((unsigned) val->_float << 23U);
@@ -645,33 +753,64 @@ void SV_WriteClientdataToMessage(edict_t *ent, sizebuf_t *msg) {
     }
 }
 
+/*
+==============================================================================
+
+The datagrams of all spawned clients are built at once, spread over the
+worker threads. Building only reads the edicts, apart from the damage and
+fixangle fields of each client's own, so the jobs don't get in each other's
+way. They are sent afterwards, one at a time.
+
+==============================================================================
+*/
+
+using svdatagram_t = struct {
+    sizebuf_t msg;
+    byte buf[MAX_DATAGRAM];
+    qboolean overflowed;
+};
+
+static std::vector<svdatagram_t> sv_datagrams;
+
 /*
 =======================
-SV_SendClientDatagram
+SV_BuildClientDatagram
 =======================
 */
-auto SV_SendClientDatagram(client_t *client) -> qboolean {
-    byte buf[MAX_DATAGRAM];
-    sizebuf_t msg;
+static void SV_BuildClientDatagram(client_t *client) {
+    auto *datagram = &sv_datagrams[client - svs.clients];
+    auto *msg = &datagram->msg;
 
-    msg.data = buf;
-    msg.maxsize = sizeof(buf);
-    msg.cursize = 0;
+    msg->data = datagram->buf;
+    msg->maxsize = sizeof(datagram->buf);
+    msg->cursize = 0;
 
-    MSG_WriteByte(&msg, svc_time);
-    MSG_WriteFloat(&msg, sv.time);
+    MSG_WriteByte(msg, svc_time);
+    MSG_WriteFloat(msg, sv.time);
 
 // add the client specific data to the datagram
-    SV_WriteClientdataToMessage(client->edict, &msg);
+    SV_WriteClientdataToMessage(client->edict, msg);
 
-    SV_WriteEntitiesToClient(client->edict, &msg);
+    datagram->overflowed = !SV_WriteEntitiesToClient(client->edict, msg);
 
 // copy the server datagram if there is space
-    if (msg.cursize + sv.datagram.cursize < msg.maxsize)
-        SZ_Write(&msg, sv.datagram.data, sv.datagram.cursize);
+    if (msg->cursize + sv.datagram.cursize < msg->maxsize)
+        SZ_Write(msg, sv.datagram.data, sv.datagram.cursize);
+}
+
+/*
+=======================
+SV_SendClientDatagram
+=======================
+*/
+auto SV_SendClientDatagram(client_t *client) -> qboolean {
+    auto *datagram = &sv_datagrams[client - svs.clients];
+
+    if (datagram->overflowed)
+        Con_Printf("packet overflow\n");
 
 // send the datagram
-    if (NET_SendUnreliableMessage(client->netconnection, &msg) == -1) {
+    if (NET_SendUnreliableMessage(client->netconnection, &datagram->msg) == -1) {
         SV_DropClient(true);// if the message couldn't send, kick off
         return false;
     }
@@ -748,6 +887,24 @@ void SV_SendClientMessages() {
 // update frags, names, etc
     SV_UpdateToReliableMessages();
 
+// build the datagrams of the spawned clients
+    std::vector<client_t *> spawned;
+    for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++) {
+        if (host_client->active && host_client->spawned)
+            spawned.push_back(host_client);
+    }
+
+    if (!spawned.empty()) {
+        if (sv_datagrams.size() < static_cast<std::size_t>(svs.maxclients))
+            sv_datagrams.resize(svs.maxclients);
+
+        SV_SetIdealPitch();        // how much to look up / down ideally
+        ED_SyncHot();            // the clients only read it
+        Thread_ParallelFor(static_cast<int>(spawned.size()), [&spawned](int n) {
+            SV_BuildClientDatagram(spawned[n]);
+        });
+    }
+
 // build individual updates
     for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++) {
         if (!host_client->active)
@@ -796,6 +953,8 @@ void SV_SendClientMessages() {
         }
     }
 
+// clients that share the listening socket were only queued for
+    NET_Flush();
 
 // clear muzzle flashes
     SV_CleanupEnts();
@@ -994,6 +1153,7 @@ void SV_SpawnServer(const std::string &server)
     sv.max_edicts = MAX_EDICTS;
 
     sv.edicts = hunkAllocName<decltype(sv.edicts)>(sv.max_edicts * pr_edict_size, "edicts");
+    ED_ResetHot();
 
     sv.datagram.maxsize = sizeof(sv.datagram_buf);
     sv.datagram.cursize = 0;
@@ -1028,6 +1188,7 @@ void SV_SpawnServer(const std::string &server)
         return;
     }
     sv.models[1] = sv.worldmodel;
+    SV_BuildVis();
 
 //
 // clear world interaction links
@@ -1049,7 +1210,7 @@ void SV_SpawnServer(const std::string &server)
     auto *ent = EDICT_NUM(0);
     memset(&ent->v, 0, progs->entityfields * 4);
     ent->free = false;
-    ent->v.model = getOffsetByString(sv.worldmodel->name);
+    ent->v.model = newString(sv.worldmodel->name);
     ent->v.modelindex = 1;        // world model
     ent->v.solid = SOLID_BSP;
     ent->v.movetype = MOVETYPE_PUSH;
@@ -1059,7 +1220,7 @@ void SV_SpawnServer(const std::string &server)
     else
         pr_global_struct->deathmatch = deathmatch.value;
 
-    pr_global_struct->mapname = getOffsetByString(sv.name);
+    pr_global_struct->mapname = newString(sv.name);
 #ifdef QUAKE2 // this might be useful
     pr_global_struct->startspot = sv.startspot - pr_strings;
 #endif
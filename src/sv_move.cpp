@@ -36,7 +36,7 @@ is not a staircase.
 int c_yes, c_no;
 
 auto SV_CheckBottom(edict_t *ent) -> qboolean {
-    vec3 mins, maxs, start, stop;
+    vec3 mins, maxs, start;
     trace_t trace;
     int x = 0, y = 0;
     float mid = NAN, bottom = NAN;
@@ -64,31 +64,41 @@ auto SV_CheckBottom(edict_t *ent) -> qboolean {
 //
 // check it for real...
 //
-    start[2] = mins[2];
+// the midpoint and the four corners are traced down together, they all
+// look at the same few entities
+//
+    vec3 starts[5], stops[5];
+    trace_t traces[5];
 
-// the midpoint must be within 16 of the bottom
-    start[0] = stop[0] = (mins[0] + maxs[0]) * 0.5f;
-    start[1] = stop[1] = (mins[1] + maxs[1]) * 0.5f;
-    stop[2] = start[2] - 2 * STEPSIZE;
-    trace = SV_Move(start, vec3_origin, vec3_origin, stop, true, ent);
+    starts[0][0] = (mins[0] + maxs[0]) * 0.5f;
+    starts[0][1] = (mins[1] + maxs[1]) * 0.5f;
+    for (x = 0; x <= 1; x++)
+        for (y = 0; y <= 1; y++) {
+            starts[1 + x * 2 + y][0] = x ? maxs[0] : mins[0];
+            starts[1 + x * 2 + y][1] = y ? maxs[1] : mins[1];
+        }
+    for (int i = 0; i < 5; i++) {
+        starts[i][2] = mins[2];
+        stops[i] = starts[i];
+        stops[i][2] = mins[2] - 2 * STEPSIZE;
+    }
+
+    SV_MoveBatch(5, starts, vec3_origin, vec3_origin, stops, MOVE_NOMONSTERS, ent, traces);
 
-    if (trace.fraction == 1.0)
+// the midpoint must be within 16 of the bottom
+    if (traces[0].fraction == 1.0)
         return false;
-    mid = bottom = trace.endpos[2];
+    mid = bottom = traces[0].endpos[2];
 
 // the corners must be within 16 of the midpoint	
-    for (x = 0; x <= 1; x++)
-        for (y = 0; y <= 1; y++) {
-            start[0] = stop[0] = x ? maxs[0] : mins[0];
-            start[1] = stop[1] = y ? maxs[1] : mins[1];
-
-            trace = SV_Move(start, vec3_origin, vec3_origin, stop, true, ent);
+    for (int i = 1; i < 5; i++) {
+        trace = traces[i];
 
-            if (trace.fraction != 1.0 && trace.endpos[2] > bottom)
-                bottom = trace.endpos[2];
-            if (trace.fraction == 1.0 || mid - trace.endpos[2] > STEPSIZE)
-                return false;
-        }
+        if (trace.fraction != 1.0 && trace.endpos[2] > bottom)
+            bottom = trace.endpos[2];
+        if (trace.fraction == 1.0 || mid - trace.endpos[2] > STEPSIZE)
+            return false;
+    }
 
     c_yes++;
     return true;
@@ -171,6 +181,7 @@ auto SV_movestep(edict_t *ent, vec3 move, qboolean relink) -> qboolean {
             if (relink)
                 SV_LinkEdict(ent, true);
             ent->v.flags = (int) ent->v.flags & ~FL_ONGROUND;
+            ED_CHANGED(ent);
 //	Con_Printf ("fall down\n"); 
             return true;
         }
@@ -195,6 +206,7 @@ auto SV_movestep(edict_t *ent, vec3 move, qboolean relink) -> qboolean {
     if ((int) ent->v.flags & FL_PARTIALGROUND) {
 //		Con_Printf ("back on ground\n"); 
         ent->v.flags = (int) ent->v.flags & ~FL_PARTIALGROUND;
+        ED_CHANGED(ent);
     }
     ent->v.groundentity = EDICT_TO_PROG(trace.ent);
 
@@ -254,6 +266,7 @@ void SV_FixCheckBottom(edict_t *ent) {
 //	Con_Printf ("SV_FixCheckBottom\n");
 
     ent->v.flags = (int) ent->v.flags | FL_PARTIALGROUND;
+    ED_CHANGED(ent);
 }
 
 
@@ -19,6 +19,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // sv_phys.c
 
+#include <algorithm>
 #include <cmath>
 #include "quakedef.hpp"
 #include "util.hpp"
@@ -129,6 +130,7 @@ auto SV_RunThink(edict_t *ent) -> qboolean {
     // it is possible to start that way
     // by a trigger with a local time.
     ent->v.nextthink = 0;
+    ED_CHANGED(ent);
     pr_global_struct->time = thinktime;
     pr_global_struct->self = EDICT_TO_PROG(ent);
     pr_global_struct->other = EDICT_TO_PROG(sv.edicts);
@@ -149,6 +151,10 @@ void SV_Impact(edict_t *e1, edict_t *e2) {
     old_self = pr_global_struct->self;
     old_other = pr_global_struct->other;
 
+    // whatever moved them hasn't necessarily relinked them yet
+    ED_CHANGED(e1);
+    ED_CHANGED(e2);
+
     pr_global_struct->time = sv.time;
     if (e1->v.touch && e1->v.solid != SOLID_NOT) {
         pr_global_struct->self = EDICT_TO_PROG(e1);
@@ -231,6 +237,16 @@ auto SV_FlyMove(edict_t *ent, double time, trace_t *steptrace) -> int {
 
     auto time_left = time;
 
+// clipping only ever slows the entity down, so every bump stays inside the
+// box it could reach at its starting speed
+    const auto reach = glm::length(ent->v.velocity) * static_cast<float>(time) + 1;
+    vec3 reachmins = ent->v.origin + ent->v.mins, reachmaxs = ent->v.origin + ent->v.maxs;
+    for (int i = 0; i < 3; i++) {
+        reachmins[i] -= reach;
+        reachmaxs[i] += reach;
+    }
+    SV_GatherMoves(reachmins, reachmaxs);
+
     for (int bumpcount = 0; bumpcount < numbumps; bumpcount++) {
         if (!ent->v.velocity[0] && !ent->v.velocity[1] && !ent->v.velocity[2])
             break;
@@ -241,7 +257,8 @@ auto SV_FlyMove(edict_t *ent, double time, trace_t *steptrace) -> int {
 
         if (trace.allsolid) {    // entity is trapped in another solid
             ent->v.velocity = vec3_origin;
-            return 3;
+            blocked = 3;
+            break;
         }
 
         if (trace.fraction > 0) {    // actually covered some distance
@@ -282,7 +299,8 @@ auto SV_FlyMove(edict_t *ent, double time, trace_t *steptrace) -> int {
         // cliped to another plane
         if (numplanes >= MAX_CLIP_PLANES) {    // this shouldn't really happen
             ent->v.velocity = vec3_origin;
-            return 3;
+            blocked = 3;
+            break;
         }
 
         planes[numplanes] = trace.plane.normal;
@@ -310,7 +328,8 @@ auto SV_FlyMove(edict_t *ent, double time, trace_t *steptrace) -> int {
             if (numplanes != 2) {
 //				Con_Printf ("clip velocity, numplanes == %i\n",numplanes);
                 ent->v.velocity = vec3_origin;
-                return 7;
+                blocked = 7;
+                break;
             }
             dir = glm::cross(planes[0], planes[1]);
             const auto d = glm::dot (dir, ent->v.velocity);
@@ -323,10 +342,11 @@ auto SV_FlyMove(edict_t *ent, double time, trace_t *steptrace) -> int {
 //
         if (glm::dot (ent->v.velocity, primal_velocity) <= 0) {
             ent->v.velocity = vec3_origin;
-            return blocked;
+            break;
         }
     }
 
+    SV_ClearGather();
     return blocked;
 }
 
@@ -348,7 +368,7 @@ void SV_AddGravity(edict_t *ent) {
 #else
     eval_t *val = nullptr;
 
-    val = GetEdictFieldValue(ent, "gravity");
+    val = GetEdictFieldValue(ent, eval_gravity);
     if (val && val->_float)
         ent_gravity = val->_float;
     else
@@ -373,18 +393,19 @@ SV_PushEntity
 Does not change the entities velocity at all
 ============
 */
-auto SV_PushEntity(edict_t *ent, vec3 push) -> trace_t {
-    trace_t trace;
-
+static auto SV_PushTrace(edict_t *ent, vec3 push) -> trace_t {
     auto end = ent->v.origin + push;
 
     if (ent->v.movetype == MOVETYPE_FLYMISSILE)
-        trace = SV_Move(ent->v.origin, ent->v.mins, ent->v.maxs, end, MOVE_MISSILE, ent);
-    else if (ent->v.solid == SOLID_TRIGGER || ent->v.solid == SOLID_NOT)
+        return SV_Move(ent->v.origin, ent->v.mins, ent->v.maxs, end, MOVE_MISSILE, ent);
+    if (ent->v.solid == SOLID_TRIGGER || ent->v.solid == SOLID_NOT)
         // only clip against bmodels
-        trace = SV_Move(ent->v.origin, ent->v.mins, ent->v.maxs, end, MOVE_NOMONSTERS, ent);
-    else
-        trace = SV_Move(ent->v.origin, ent->v.mins, ent->v.maxs, end, MOVE_NORMAL, ent);
+        return SV_Move(ent->v.origin, ent->v.mins, ent->v.maxs, end, MOVE_NOMONSTERS, ent);
+    return SV_Move(ent->v.origin, ent->v.mins, ent->v.maxs, end, MOVE_NORMAL, ent);
+}
+
+auto SV_PushEntity(edict_t *ent, vec3 push) -> trace_t {
+    auto trace = SV_PushTrace(ent, push);
 
     ent->v.origin = trace.endpos;
     SV_LinkEdict(ent, true);
@@ -1179,15 +1200,13 @@ void SV_CheckWaterTransition(edict_t *ent) {
 
 /*
 =============
-SV_Physics_Toss
+SV_StartToss
 
-Toss, bounce, and fly movement.  When onground, do nothing.
+Everything a toss does before it moves. Returns false if the entity isn't
+going to move this frame.
 =============
 */
-void SV_Physics_Toss(edict_t *ent) {
-    trace_t trace;
-    vec3 move;
-    float backoff = NAN;
+static auto SV_StartToss(edict_t *ent) -> qboolean {
 #ifdef QUAKE2
     edict_t	*groundentity;
 
@@ -1200,7 +1219,7 @@ void SV_Physics_Toss(edict_t *ent) {
 #endif
     // regular thinking
     if (!SV_RunThink(ent))
-        return;
+        return false;
 
 #ifdef QUAKE2
     if (ent->v.velocity[2] > 0)
@@ -1209,7 +1228,7 @@ void SV_Physics_Toss(edict_t *ent) {
     if ( ((int)ent->v.flags & FL_ONGROUND) )
 //@@
         if (VectorCompare(ent->v.basevelocity, vec_origin))
-            return;
+            return false;
 
     SV_CheckVelocity (ent);
 
@@ -1223,7 +1242,7 @@ void SV_Physics_Toss(edict_t *ent) {
 #else
 // if onground, return without moving
     if (((int) ent->v.flags & FL_ONGROUND))
-        return;
+        return false;
 
     SV_CheckVelocity(ent);
 
@@ -1235,17 +1254,20 @@ void SV_Physics_Toss(edict_t *ent) {
 
 // move angles
     VectorMA(ent->v.angles, host_frametime, ent->v.avelocity, ent->v.angles);
+    return true;
+}
 
-// move origin
-#ifdef QUAKE2
-    ent->v.velocity = ent->v.velocity + ent->v.basevelocity;
-#endif
-    move = ent->v.velocity * static_cast<float>(host_frametime);
-    trace = SV_PushEntity(ent, move);
-#ifdef QUAKE2
-    ent->v.velocity = ent->v.velocity - ent->v.basevelocity;
-#endif
-    if (trace.fraction == 1)
+/*
+=============
+SV_FinishToss
+
+Bounces or lands a toss after its move
+=============
+*/
+static void SV_FinishToss(edict_t *ent, const trace_t *trace) {
+    float backoff = NAN;
+
+    if (trace->fraction == 1)
         return;
     if (ent->free)
         return;
@@ -1259,10 +1281,10 @@ void SV_Physics_Toss(edict_t *ent) {
     else
         backoff = 1;
 
-    ClipVelocity(ent->v.velocity, trace.plane.normal, ent->v.velocity, backoff);
+    ClipVelocity(ent->v.velocity, trace->plane.normal, ent->v.velocity, backoff);
 
 // stop if on ground
-    if (trace.plane.normal[2] > 0.7) {
+    if (trace->plane.normal[2] > 0.7) {
 #ifdef QUAKE2
         if (ent->v.velocity[2] < 60 || (ent->v.movetype != MOVETYPE_BOUNCE && ent->v.movetype != MOVETYPE_BOUNCEMISSILE))
 #else
@@ -1270,7 +1292,7 @@ void SV_Physics_Toss(edict_t *ent) {
 #endif
         {
             ent->v.flags = (int) ent->v.flags | FL_ONGROUND;
-            ent->v.groundentity = EDICT_TO_PROG(trace.ent);
+            ent->v.groundentity = EDICT_TO_PROG(trace->ent);
             ent->v.velocity = vec3_origin;
             ent->v.avelocity = vec3_origin;
         }
@@ -1280,6 +1302,213 @@ void SV_Physics_Toss(edict_t *ent) {
     SV_CheckWaterTransition(ent);
 }
 
+/*
+=============
+SV_Physics_Toss
+
+Toss, bounce, and fly movement.  When onground, do nothing.
+=============
+*/
+void SV_Physics_Toss(edict_t *ent) {
+    trace_t trace;
+    vec3 move;
+
+    if (!SV_StartToss(ent))
+        return;
+
+// move origin
+#ifdef QUAKE2
+    ent->v.velocity = ent->v.velocity + ent->v.basevelocity;
+#endif
+    move = ent->v.velocity * static_cast<float>(host_frametime);
+    trace = SV_PushEntity(ent, move);
+#ifdef QUAKE2
+    ent->v.velocity = ent->v.velocity - ent->v.basevelocity;
+#endif
+
+    SV_FinishToss(ent, &trace);
+}
+
+/*
+===============================================================================
+
+PARALLEL TOSS
+
+With sv_parallelphysics, tossed and flying entities think in edict order as
+usual, but only move once every other entity has run. The moves are traced
+on the worker threads in phases. An entity goes in the phase after the last
+earlier entity whose move it could run into, so no trace can see an entity
+that moves in the same phase. Between phases the movers are relinked
+without touching anything. When all the moves are done, the touches,
+impacts and bounces are run in edict order.
+
+===============================================================================
+*/
+
+// run toss, bounce and fly movement in parallel
+cvar_t sv_parallelphysics = {"sv_parallelphysics", "0"};
+
+using tossmove_t = struct {
+    edict_t *ent;
+    vec3 move;
+    vec3 boxmins, boxmaxs;    // everything the move could touch or be touched in
+    int phase;
+    trace_t trace;
+    int backups;            // printed after the move, see sv_tracebackups
+};
+
+static std::vector<tossmove_t> sv_tossmoves;        // in edict order
+static std::vector<int> sv_tossorder;
+static std::vector<std::pair<int, int>> sv_tossafter;    // (later, earlier) moves that overlap
+static std::vector<int> sv_tossphases;                // moves sorted by phase
+static std::vector<int> sv_tossphasestart;
+
+/*
+=============
+SV_QueueToss
+
+Runs the first half of SV_Physics_Toss and saves the move for later
+=============
+*/
+static void SV_QueueToss(edict_t *ent) {
+    tossmove_t move;
+
+    if (!SV_StartToss(ent))
+        return;
+
+    move.ent = ent;
+#ifdef QUAKE2
+    move.move = (ent->v.velocity + ent->v.basevelocity) * static_cast<float>(host_frametime);
+#else
+    move.move = ent->v.velocity * static_cast<float>(host_frametime);
+#endif
+
+// cover the box the entity is linked with now and after the move, and the
+// box a missile clips monsters with
+    for (int i = 0; i < 3; i++) {
+        const auto lo = std::min(ent->v.mins[i], -15.0F) - 16;
+        const auto hi = std::max(ent->v.maxs[i], 15.0F) + 16;
+
+        move.boxmins[i] = ent->v.origin[i] + lo + std::min(move.move[i], 0.0F);
+        move.boxmaxs[i] = ent->v.origin[i] + hi + std::max(move.move[i], 0.0F);
+        if (ent->arealist) {
+            move.boxmins[i] = std::min(move.boxmins[i], ent->v.absmin[i]);
+            move.boxmaxs[i] = std::max(move.boxmaxs[i], ent->v.absmax[i]);
+        }
+    }
+    move.phase = 0;
+    move.backups = 0;
+
+    sv_tossmoves.push_back(move);
+}
+
+/*
+=============
+SV_PhaseTosses
+
+Sorts the queued moves into phases, sweeping along x for the pairs that
+overlap
+=============
+*/
+static auto SV_PhaseTosses() -> int {
+    const auto count = static_cast<int>(sv_tossmoves.size());
+
+    sv_tossorder.resize(count);
+    for (int i = 0; i < count; i++)
+        sv_tossorder[i] = i;
+    std::sort(sv_tossorder.begin(), sv_tossorder.end(), [](int a, int b) {
+        if (sv_tossmoves[a].boxmins[0] != sv_tossmoves[b].boxmins[0])
+            return sv_tossmoves[a].boxmins[0] < sv_tossmoves[b].boxmins[0];
+        return a < b;
+    });
+
+    sv_tossafter.clear();
+    for (int i = 0; i < count; i++) {
+        const auto *a = &sv_tossmoves[sv_tossorder[i]];
+
+        for (int j = i + 1; j < count; j++) {
+            const auto *b = &sv_tossmoves[sv_tossorder[j]];
+            if (b->boxmins[0] > a->boxmaxs[0])
+                break;
+            if (b->boxmins[1] > a->boxmaxs[1] || b->boxmaxs[1] < a->boxmins[1]
+                || b->boxmins[2] > a->boxmaxs[2] || b->boxmaxs[2] < a->boxmins[2])
+                continue;
+
+            sv_tossafter.emplace_back(std::max(sv_tossorder[i], sv_tossorder[j]),
+                                      std::min(sv_tossorder[i], sv_tossorder[j]));
+        }
+    }
+
+// a move goes after every earlier move it overlaps
+    std::sort(sv_tossafter.begin(), sv_tossafter.end());
+    auto numphases = count ? 1 : 0;
+    for (const auto &[later, earlier]: sv_tossafter) {
+        auto *move = &sv_tossmoves[later];
+        move->phase = std::max(move->phase, sv_tossmoves[earlier].phase + 1);
+        numphases = std::max(numphases, move->phase + 1);
+    }
+
+    sv_tossphasestart.assign(numphases + 1, 0);
+    for (const auto &move: sv_tossmoves)
+        sv_tossphasestart[move.phase + 1]++;
+    for (int i = 0; i < numphases; i++)
+        sv_tossphasestart[i + 1] += sv_tossphasestart[i];
+
+    sv_tossphases.resize(count);
+    sv_tossorder.assign(sv_tossphasestart.begin(), sv_tossphasestart.end() - 1);
+    for (int i = 0; i < count; i++)
+        sv_tossphases[sv_tossorder[sv_tossmoves[i].phase]++] = i;
+
+    return numphases;
+}
+
+/*
+=============
+SV_RunTosses
+
+Moves everything SV_QueueToss saved
+=============
+*/
+static void SV_RunTosses() {
+    const auto numphases = SV_PhaseTosses();
+
+    SV_ClearGather();
+    for (int phase = 0; phase < numphases; phase++) {
+        const auto *first = sv_tossphases.data() + sv_tossphasestart[phase];
+        const auto count = sv_tossphasestart[phase + 1] - sv_tossphasestart[phase];
+
+        Thread_ParallelFor(count, [first](int i) {
+            auto *move = &sv_tossmoves[first[i]];
+            sv_tracebackups = &move->backups;
+            move->trace = SV_PushTrace(move->ent, move->move);
+            sv_tracebackups = nullptr;
+        });
+
+        for (int i = 0; i < count; i++) {
+            auto *move = &sv_tossmoves[first[i]];
+            if (move->backups)
+                Con_DPrintf("backup past 0\n");
+            move->ent->v.origin = move->trace.endpos;
+            SV_LinkEdict(move->ent, false);
+        }
+    }
+
+// touch, in edict order
+    for (auto &move: sv_tossmoves) {
+        auto *ent = move.ent;
+        if (ent->free)
+            continue;        // removed by an earlier touch
+
+        SV_LinkEdict(ent, true);
+        if (move.trace.ent && !move.trace.ent->free)
+            SV_Impact(ent, move.trace.ent);
+
+        SV_FinishToss(ent, &move.trace);
+    }
+
+    sv_tossmoves.clear();
+}
+
 /*
 ===============================================================================
 
@@ -1438,6 +1667,33 @@ void SV_Physics_Step(edict_t *ent) {
 
 //============================================================================
 
+/*
+================
+SV_Resting
+
+True if the entity has nothing to do this frame: it doesn't move by itself
+and it isn't time for it to think. Only looks at the hot fields, so the
+edict itself is never touched.
+================
+*/
+static auto SV_Resting(int num) -> bool {
+    const auto thinktime = ed_hot.nextthink[num];
+    if (!(thinktime <= 0 || thinktime > sv.time + host_frametime))
+        return false;
+
+    const auto movetype = ed_hot.movetype[num];
+    if (movetype == MOVETYPE_NONE)
+        return true;
+#ifndef QUAKE2
+    if (movetype == MOVETYPE_TOSS
+        || movetype == MOVETYPE_BOUNCE
+        || movetype == MOVETYPE_FLY
+        || movetype == MOVETYPE_FLYMISSILE)
+        return ((int) ed_hot.flags[num] & FL_ONGROUND) != 0;
+#endif
+    return false;
+}
+
 /*
 ================
 SV_Physics
@@ -1456,17 +1712,29 @@ void SV_Physics() {
 
 //SV_CheckAllEnts ();
 
+    const auto parallel = sv_parallelphysics.value != 0;
+    sv_tossmoves.clear();
+
+    ED_WakeThinks(sv.time + host_frametime);
+
 //
-// treat each object in turn
+// treat each object in turn. Past the clients, only the edicts that have
+// changed or have a think due can have anything to do.
 //
-    ent = sv.edicts;
-    for (i = 0; i < sv.num_edicts; i++, ent = NEXT_EDICT(ent)) {
-        if (ent->free)
+    for (i = 0; i < sv.num_edicts; i++) {
+        if (i <= svs.maxclients || pr_global_struct->force_retouch)
+            ED_SyncHot(i);
+        else if ((i = ED_NextPending(i)) == sv.num_edicts)
+            break;
+
+        ent = EDICT_NUM(i);
+        if (ed_hot.free[i])
             continue;
 
         if (pr_global_struct->force_retouch) {
-            SV_LinkEdict(ent, true);    // force retouch even for stationary
-        }
+            SV_RetouchEdict(ent);    // force retouch even for stationary
+        } else if (i > svs.maxclients && SV_Resting(i))
+            continue;
 
         if (i > 0 && i <= svs.maxclients)
             SV_Physics_Client(ent, i);
@@ -1488,12 +1756,20 @@ void SV_Physics() {
                  || ent->v.movetype == MOVETYPE_BOUNCEMISSILE
                  #endif
                  || ent->v.movetype == MOVETYPE_FLY
-                 || ent->v.movetype == MOVETYPE_FLYMISSILE)
-            SV_Physics_Toss(ent);
-        else
+                 || ent->v.movetype == MOVETYPE_FLYMISSILE) {
+            if (parallel)
+                SV_QueueToss(ent);
+            else
+                SV_Physics_Toss(ent);
+        } else
             Sys_Error("SV_Physics: bad movetype %i", (int) ent->v.movetype);
+
+        ED_CHANGED(ent);    // the physics write its fields directly
     }
 
+    if (parallel)
+        SV_RunTosses();
+
     if (pr_global_struct->force_retouch)
         pr_global_struct->force_retouch--;
 
@@ -288,6 +288,7 @@ void SV_WaterJump() {
     if (sv.time > sv_player->v.teleport_time
         || !sv_player->v.waterlevel) {
         sv_player->v.flags = (int) sv_player->v.flags & ~FL_WATERJUMP;
+        ED_CHANGED(sv_player);
         sv_player->v.teleport_time = 0;
     }
     sv_player->v.velocity[0] = sv_player->v.movedir[0];
@@ -428,6 +429,13 @@ void SV_ReadClientMove(usercmd_t *move) {
     if (i)
         host_client->edict->v.impulse = i;
 
+// read the last entity frame the client has
+    if (host_client->protocol == PROTOCOL_DELTA) {
+        i = MSG_ReadLong();
+        if (i >= 0 && i <= host_client->entityframe)
+            host_client->ackframe = i;
+    }
+
 #ifdef QUAKE2
     // read light level
         host_client->edict->v.light_level = MSG_ReadByte ();
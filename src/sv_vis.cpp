@@ -0,0 +1,203 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sv_vis.cpp -- decompressed potentially visible and hearable sets
+
+#include <cstdint>
+#include "quakedef.hpp"
+
+/*
+==============================================================================
+
+The world's vis is decompressed once when the server spawns, one row of
+bits per leaf, padded to whole 64 bit words so rows can be or'ed a word at
+a time. Bit n of a row is leaf n + 1, as in the compressed vis.
+
+The PHS of a leaf is its PVS together with the PVS of every leaf it can
+see: everything a sound made there could reasonably reach.
+
+==============================================================================
+*/
+
+// drop sounds no client could hear. Off by default, as the sound goes by
+// its entity's center and not by where each client is.
+cvar_t sv_phs = {"sv_phs", "0"};
+
+static std::vector<std::uint64_t> vis_pvs;
+static std::vector<std::uint64_t> vis_phs;
+static int vis_rowwords;
+static int vis_rows;
+static int vis_generation;        // bumped for every map, to invalidate the fat PVS cache
+
+// a client's fat PVS, and the leafs it was built from
+using fatpvs_t = struct {
+    int generation;
+    std::vector<int> leafs;
+    std::vector<std::uint64_t> bits;
+};
+
+static std::vector<fatpvs_t> fatpvs_cache;        // one for each client slot
+
+static auto SV_VisRow(std::vector<std::uint64_t> &vis, int leafnum) -> std::uint64_t * {
+    return vis.data() + static_cast<std::size_t>(leafnum) * vis_rowwords;
+}
+
+/*
+================
+SV_BuildVis
+
+Called after the world model is loaded
+================
+*/
+void SV_BuildVis() {
+    auto *model = sv.worldmodel;
+    const auto rowbytes = (model->numleafs + 7) >> 3;
+
+    vis_rows = model->numleafs + 1;
+    vis_rowwords = (model->numleafs + 63) >> 6;
+    vis_generation++;
+    fatpvs_cache.resize(svs.maxclients);        // sized up front, clients are built in parallel
+
+    vis_pvs.assign(static_cast<std::size_t>(vis_rows) * vis_rowwords, 0);
+    for (int i = 0; i < vis_rows; i++)
+        memcpy(SV_VisRow(vis_pvs, i), Mod_LeafPVS(model->leafs + i, model), rowbytes);
+
+    vis_phs = vis_pvs;
+    for (int i = 0; i < vis_rows; i++) {
+        auto *dest = SV_VisRow(vis_phs, i);
+
+        Bits_ForEachSet(SV_VisRow(vis_pvs, i), model->numleafs, [dest](int n) {
+            Bits_Or(dest, SV_VisRow(vis_pvs, n + 1), vis_rowwords);
+        });
+    }
+
+    Con_DPrintf("%i leafs, %i KB of PVS and PHS\n", model->numleafs,
+                static_cast<int>((vis_pvs.size() + vis_phs.size()) * sizeof(std::uint64_t) / 1024));
+}
+
+/*
+================
+SV_LeafPVS
+
+The decompressed PVS of a world leaf, valid until the next map
+================
+*/
+auto SV_LeafPVS(mleaf_t *leaf) -> const byte * {
+    return reinterpret_cast<const byte *>(SV_VisRow(vis_pvs, static_cast<int>(leaf - sv.worldmodel->leafs)));
+}
+
+/*
+================
+SV_LeafPHS
+================
+*/
+auto SV_LeafPHS(mleaf_t *leaf) -> const byte * {
+    return reinterpret_cast<const byte *>(SV_VisRow(vis_phs, static_cast<int>(leaf - sv.worldmodel->leafs)));
+}
+
+/*
+=============================================================================
+
+The PVS must include a small area around the client to allow head bobbing
+or other small motion on the client side.  Otherwise, a bob might cause an
+entity that should be visible to not show up, especially when the bob
+crosses a waterline.
+
+Most frames a client touches the same leafs as in the last one, so each
+client keeps the leafs its fat PVS was built from and only rebuilds it
+when they change.
+
+=============================================================================
+*/
+
+static thread_local std::vector<int> fatpvs_leafs;
+
+static void SV_AddToFatPVS(const vec3 org, mnode_t *node) {
+    while (true) {
+        // if this is a leaf, accumulate the pvs bits
+        if (node->contents < 0) {
+            if (node->contents != CONTENTS_SOLID)
+                fatpvs_leafs.push_back(static_cast<int>(reinterpret_cast<mleaf_t *>(node) - sv.worldmodel->leafs));
+            return;
+        }
+
+        const auto *plane = node->plane;
+        const auto d = glm::dot(org, plane->normal) - plane->dist;
+        if (d > 8)
+            node = node->children[0];
+        else if (d < -8)
+            node = node->children[1];
+        else {    // go down both
+            SV_AddToFatPVS(org, node->children[0]);
+            node = node->children[1];
+        }
+    }
+}
+
+/*
+=============
+SV_FatPVS
+
+Calculates a PVS that is the inclusive or of all leafs within 8 pixels of the
+given point, for the client in slot clientnum. Safe to call for different
+clients at once.
+=============
+*/
+auto SV_FatPVS(const vec3 org, int clientnum) -> const byte * {
+    fatpvs_leafs.clear();
+    SV_AddToFatPVS(org, sv.worldmodel->nodes);
+
+    auto *cache = &fatpvs_cache[clientnum];
+
+    if (cache->generation != vis_generation || cache->leafs != fatpvs_leafs) {
+        cache->generation = vis_generation;
+        cache->leafs = fatpvs_leafs;
+        cache->bits.assign(vis_rowwords, 0);
+        for (const auto leafnum: fatpvs_leafs)
+            Bits_Or(cache->bits.data(), SV_VisRow(vis_pvs, leafnum), vis_rowwords);
+    }
+
+    return reinterpret_cast<const byte *>(cache->bits.data());
+}
+
+/*
+=============
+SV_CanHear
+
+True if the point is in the PHS of at least one spawned client
+=============
+*/
+auto SV_CanHear(vec3 org) -> bool {
+    const auto leafnum = static_cast<int>(Mod_PointInLeaf(org, sv.worldmodel) - sv.worldmodel->leafs) - 1;
+    if (leafnum < 0)
+        return true;        // in solid, let the client sort it out
+
+    for (int i = 0; i < svs.maxclients; i++) {
+        const auto *client = &svs.clients[i];
+        if (!client->active || !client->spawned)
+            continue;
+
+        vec3 view = client->edict->v.origin + client->edict->v.view_ofs;
+        const auto *phs = SV_LeafPHS(Mod_PointInLeaf(view, sv.worldmodel));
+        if (phs[leafnum >> 3] & (1 << (leafnum & 7)))
+            return true;
+    }
+
+    return false;
+}
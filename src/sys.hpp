@@ -43,6 +43,11 @@ int Sys_FileWrite(int handle, const void *src, int count);
 
 int Sys_FileTime(std::string_view path);
 
+void *Sys_FileMap(const char *path, int *size);
+// private, writable mapping of a whole file, NULL if it can't be mapped
+
+void Sys_FileUnmap(void *data, int size);
+
 void Sys_mkdir(const char *path);
 
 //
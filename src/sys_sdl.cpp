@@ -2,6 +2,9 @@
 #include <csignal>
 #include <cstdlib>
 #include <climits>
+#include <cstdint>
+#include <ctime>
+#include <sys/select.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -20,7 +23,16 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/mman.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#endif
+
+#ifdef SDL
 #include <SDL.h>
+#endif
 
 
 #endif
@@ -30,6 +42,8 @@
 
 qboolean isDedicated;
 
+static int sys_instance;        // which of the -instances servers this is
+
 constexpr auto basedir = ".";
 constexpr auto cachedir = "/tmp";
 
@@ -215,7 +229,48 @@ auto Sys_FileWrite(int handle, const void *src, int count) -> int {
 }
 
 auto Sys_FileTime(std::string_view path) -> int {
-    return std::filesystem::exists(path) ? 1 : -1;
+    struct stat buf{};
+
+    if (stat(std::string(path).c_str(), &buf) == -1)
+        return -1;
+
+    return static_cast<int>(buf.st_mtime);
+}
+
+/*
+================
+Sys_FileMap
+
+Maps a whole file copy on write. Pages that are never written stay shared
+with every other process that maps it. NULL if the file can't be mapped.
+================
+*/
+auto Sys_FileMap(const char *path, int *size) -> void * {
+#ifdef __WIN32__
+    return nullptr;
+#else
+    const auto fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return nullptr;
+
+    struct stat buf{};
+    void *data = MAP_FAILED;
+    if (fstat(fd, &buf) == 0 && buf.st_size > 0 && buf.st_size <= INT_MAX)
+        data = mmap(nullptr, buf.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    *size = static_cast<int>(buf.st_size);
+    return data;
+#endif
+}
+
+void Sys_FileUnmap(void *data, int size) {
+#ifndef __WIN32__
+    munmap(data, size);
+#endif
 }
 
 void Sys_mkdir(const char *path) {
@@ -239,6 +294,17 @@ void Sys_DebugLog(char *file, char *fmt, ...) {
     fclose(fp);
 }
 
+#ifndef __WIN32__
+// the monotonic clock, so tics keep their spacing when the date is set
+static std::int64_t sys_timebase;        // whole seconds of the first reading
+
+static auto Sys_Nanoseconds() -> std::int64_t {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+#endif
+
 auto Sys_FloatTime() -> double {
 #ifdef __WIN32__
 
@@ -251,18 +317,12 @@ auto Sys_FloatTime() -> double {
 
 #else
 
-    timeval tp{};
-    struct timezone tzp{};
-    static int secbase;
-
-    gettimeofday(&tp, &tzp);
+    const auto now = Sys_Nanoseconds();
 
-    if (!secbase) {
-        secbase = tp.tv_sec;
-        return tp.tv_usec / 1000000.0;
-    }
+    if (!sys_timebase)
+        sys_timebase = now / 1000000000 * 1000000000;
 
-    return (tp.tv_sec - secbase) + tp.tv_usec / 1000000.0;
+    return static_cast<double>(now - sys_timebase) / 1e9;
 
 #endif
 }
@@ -297,9 +357,196 @@ void Sys_LineRefresh() {
 }
 
 void Sys_Sleep() {
+#ifdef SDL
     SDL_Delay(1);
+#else
+    usleep(1000);
+#endif
 }
 
+#ifdef __linux__
+/*
+================
+Sys_WaitForTic
+
+Sleeps until Sys_FloatTime reaches deadline, on a timer set for exactly
+then. Datagrams that arrive on the server's sockets meanwhile wake it up
+to be read ahead of the frame.
+================
+*/
+static void Sys_WaitForTic(double deadline) {
+    static int epollfd = -1;
+    static int timerfd = -1;
+    static std::vector<int> watched;
+    static std::vector<int> sockets;
+
+    if (epollfd == -1) {
+        epollfd = epoll_create1(EPOLL_CLOEXEC);
+        timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (epollfd == -1 || timerfd == -1)
+            Sys_Error("Sys_WaitForTic: %s", strerror(errno));
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = timerfd;
+        epoll_ctl(epollfd, EPOLL_CTL_ADD, timerfd, &event);
+    }
+
+    // the sockets change when the server starts or stops listening
+    NET_WaitHandles(sockets);
+    for (const auto socket: watched)
+        if (std::ranges::find(sockets, socket) == sockets.end())
+            epoll_ctl(epollfd, EPOLL_CTL_DEL, socket, nullptr);
+
+    // a socket closed and opened again can come back with the same number,
+    // and closing it took it out of the set, so every one is added again
+    // and the ones still in it fail with EEXIST
+    for (const auto socket: sockets) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = socket;
+        if (epoll_ctl(epollfd, EPOLL_CTL_ADD, socket, &event) == -1 && errno != EEXIST)
+            Con_DPrintf("Sys_WaitForTic: %s\n", strerror(errno));
+    }
+    watched = sockets;
+
+    const auto when = sys_timebase + static_cast<std::int64_t>(deadline * 1e9);
+    itimerspec timer{};
+    timer.it_value.tv_sec = static_cast<time_t>(when / 1000000000);
+    timer.it_value.tv_nsec = static_cast<long>(when % 1000000000);
+    timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &timer, nullptr);
+
+    while (Sys_FloatTime() < deadline) {
+        epoll_event events[8];
+        const auto count = epoll_wait(epollfd, events, 8, -1);
+        if (count == -1) {
+            if (errno == EINTR)
+                continue;
+            Sys_Error("Sys_WaitForTic: %s", strerror(errno));
+        }
+
+        qboolean arrived = false;
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.fd == timerfd) {
+                std::uint64_t expirations;
+                read(timerfd, &expirations, sizeof(expirations));
+            } else
+                arrived = true;
+        }
+        if (arrived)
+            NET_ReadAhead();
+    }
+}
+#else
+/*
+================
+Sys_WaitForTic
+
+Sleeps until Sys_FloatTime reaches deadline, to the microsecond
+================
+*/
+static void Sys_WaitForTic(double deadline) {
+    const auto seconds = deadline - Sys_FloatTime();
+    if (seconds <= 0)
+        return;
+
+    timeval timeout{};
+    timeout.tv_sec = static_cast<long>(seconds);
+    timeout.tv_usec = static_cast<long>((seconds - timeout.tv_sec) * 1000000.0);
+    select(0, nullptr, nullptr, nullptr, &timeout);
+}
+#endif
+
+/*
+================
+Sys_ConsoleInput
+
+A line typed on a dedicated server's terminal, if there is one waiting
+================
+*/
+auto Sys_ConsoleInput() -> char * {
+    static char text[256];
+    static qboolean closed;        // stdin hit end of file, don't spin on it
+
+    if (cls.state != ca_dedicated || closed || sys_instance > 0)
+        return nullptr;        // the terminal only talks to the first instance
+
+    fd_set fdset;
+    FD_ZERO(&fdset);
+    FD_SET(STDIN_FILENO, &fdset);
+    timeval timeout{};
+    if (select(STDIN_FILENO + 1, &fdset, nullptr, nullptr, &timeout) <= 0 || !FD_ISSET(STDIN_FILENO, &fdset))
+        return nullptr;
+
+    const auto len = read(STDIN_FILENO, text, sizeof(text) - 1);
+    if (len < 1) {
+        closed = len == 0;
+        return nullptr;
+    }
+    text[len - 1] = 0;        // rip off the \n and terminate
+
+    return text;
+}
+
+#ifndef __WIN32__
+/*
+================
+Sys_ForkInstances
+
+-instances n runs n independent servers from one start up, the first on
+the port the host was given and each of the others on the next one up.
+They are forked after Host_Init, so the engine, the preloaded maps and
+the game directory's pak headers stay shared copy on write, and each
+instance still gets its own server, progs and hunk to scribble on.
+
+Any other map an instance loads with map or changelevel is its own, and
+so are the progs. With -bakedir the instances map the same baked copy of
+every map instead, so most of one is shared whichever way it was loaded.
+
+The original process only waits for them, and takes them all down with
+it if it is killed.
+================
+*/
+static void Sys_ForkInstances() {
+    const auto i = COM_CheckParm("-instances");
+    if (!i || i >= com_argc - 1)
+        return;
+
+    const auto count = Q_atoi(com_argv[i + 1]);
+    if (count < 2)
+        return;
+
+    std::vector<pid_t> children;
+    for (int n = 0; n < count; n++) {
+        const auto pid = fork();
+        if (pid == -1)
+            Sys_Error("Sys_ForkInstances: %s", strerror(errno));
+
+        if (pid == 0) {
+#ifdef __linux__
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+            sys_instance = n;
+            // the first keeps the socket it was forked with, the rest move up
+            if (n > 0)
+                Cbuf_AddText(va("port %i\n", net_hostport + n));
+            return;
+        }
+        children.push_back(pid);
+    }
+
+    sysPrintf("%i server instances on ports %i to %i\n", count, net_hostport, net_hostport + count - 1);
+    if (!COM_CheckParm("-bakedir"))
+        sysPrintf("Only the -preload maps are shared, -bakedir shares every map\n");
+
+    NET_Shutdown();        // the instances have their own copies of the sockets
+    for (const auto pid: children)
+        while (waitpid(pid, nullptr, 0) == -1 && errno == EINTR)
+            ;
+    exit(0);
+}
+#endif
+
 void floating_point_exception_handler(int whatever) {
 //	Sys_Warn("floating point exception\n");
     signal(SIGFPE, floating_point_exception_handler);
@@ -308,25 +555,45 @@ void floating_point_exception_handler(int whatever) {
 auto main(int c, char **v) -> int {
     extern int vcrFile;
     extern bool recording;
+#ifdef DEDICATED
+    // no textures, sounds or video buffers to make room for
+    constexpr int memPoolSize = sizeof(void *) * 4 * 1024 * 1024;
+#else
     constexpr int memPoolSize = sizeof(void *) * 16 * 1024 * 1024;
+#endif
 
     COM_InitArgv(c, v);
 //	signal(SIGFPE, floating_point_exception_handler);
     signal(SIGFPE, SIG_IGN);
 
+#ifdef DEDICATED
+    isDedicated = true;
+#else
+    isDedicated = COM_CheckParm("-dedicated") != 0;
+#endif
+
+    auto memSize = memPoolSize;
+    if (const auto i = COM_CheckParm("-mem"); i && i < com_argc - 1)
+        memSize = static_cast<int>(strtod(com_argv[i + 1], nullptr) * 1024 * 1024);
+
     quakeparms_t parms = {
             .basedir = basedir,
             .cachedir = cachedir,
             .argc = com_argc,
             .argv = com_argv,
-            .membase = malloc(memPoolSize),
-            .memsize = memPoolSize,
+            .membase = malloc(memSize),
+            .memsize = memSize,
     };
 
     Sys_Init();
 
     Host_Init(&parms);
 
+#ifndef __WIN32__
+    if (cls.state == ca_dedicated)
+        Sys_ForkInstances();
+#endif
+
     Cvar_RegisterVariable(&sys_nostdout);
 
     double oldtime = Sys_FloatTime() - 0.1;
@@ -339,7 +606,7 @@ auto main(int c, char **v) -> int {
 
         if (cls.state == ca_dedicated) {   // play vcrfiles at max speed
             if (time < sys_ticrate.value && (vcrFile == -1 || recording)) {
-                SDL_Delay(1);
+                Sys_WaitForTic(oldtime + sys_ticrate.value);
                 continue;       // not time to run a server only tic yet
             }
             time = sys_ticrate.value;
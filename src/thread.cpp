@@ -0,0 +1,158 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// thread.cpp -- a pool of worker threads for splitting up frame work
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "quakedef.hpp"
+
+// threads to run parallel work on, 0 for one per core
+cvar_t host_threads = {"host_threads", "0"};
+
+static std::vector<std::thread> workers;
+static std::thread::id main_thread;
+
+static std::mutex job_lock;
+static std::condition_variable job_start;
+static std::condition_variable job_done;
+static const std::function<void(int)> *job_function;
+static int job_count;
+static std::atomic<int> job_next;
+static int job_busy;            // workers still on the job
+static unsigned job_generation;    // bumped for every job
+static bool job_quit;
+
+static void Thread_RunJob() {
+    for (int i; (i = job_next.fetch_add(1, std::memory_order_relaxed)) < job_count;)
+        (*job_function)(i);
+}
+
+static void Thread_Worker(unsigned generation) {
+    std::unique_lock lock(job_lock);
+
+    while (true) {
+        job_start.wait(lock, [&generation] { return job_quit || job_generation != generation; });
+        if (job_quit)
+            return;
+        generation = job_generation;
+
+        lock.unlock();
+        Thread_RunJob();
+        lock.lock();
+
+        if (!--job_busy)
+            job_done.notify_one();
+    }
+}
+
+static void Thread_StopWorkers() {
+    {
+        std::lock_guard lock(job_lock);
+        job_quit = true;
+    }
+    job_start.notify_all();
+
+    for (auto &worker: workers)
+        worker.join();
+    workers.clear();
+    job_quit = false;
+}
+
+/*
+================
+Thread_StartWorkers
+
+Matches the pool to host_threads, counting the main thread as one
+================
+*/
+static void Thread_StartWorkers() {
+    auto threads = static_cast<int>(host_threads.value);
+    if (threads <= 0)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::clamp(threads, 1, 64);
+
+    if (static_cast<int>(workers.size()) == threads - 1)
+        return;
+
+    Thread_StopWorkers();
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back(Thread_Worker, job_generation);
+}
+
+/*
+================
+Thread_ParallelFor
+================
+*/
+void Thread_ParallelFor(int count, const std::function<void(int)> &job) {
+    if (std::this_thread::get_id() == main_thread)
+        Thread_StartWorkers();
+
+    if (workers.empty() || count < 2 || std::this_thread::get_id() != main_thread) {
+        for (int i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+
+    {
+        std::lock_guard lock(job_lock);
+        job_function = &job;
+        job_count = count;
+        job_next.store(0, std::memory_order_relaxed);
+        job_busy = static_cast<int>(workers.size());
+        job_generation++;
+    }
+    job_start.notify_all();
+
+    Thread_RunJob();
+
+    std::unique_lock lock(job_lock);
+    job_done.wait(lock, [] { return !job_busy; });
+}
+
+/*
+================
+Thread_Init
+================
+*/
+void Thread_Init() {
+    main_thread = std::this_thread::get_id();
+    Cvar_RegisterVariable(&host_threads);
+}
+
+/*
+================
+Thread_Shutdown
+================
+*/
+void Thread_Shutdown() {
+    if (std::this_thread::get_id() != main_thread) {
+        // an error in a job, let exit take the threads down
+        for (auto &worker: workers)
+            worker.detach();
+        workers.clear();
+        return;
+    }
+
+    Thread_StopWorkers();
+}
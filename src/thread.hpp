@@ -0,0 +1,34 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+#pragma once
+
+/* thread.h -- a pool of worker threads for splitting up frame work */
+
+#include <functional>
+
+extern cvar_t host_threads;
+
+void Thread_Init();
+
+void Thread_Shutdown();
+
+// runs job(0) .. job(count - 1) spread over the workers and the calling
+// thread, and returns when all of them are done. Jobs must not call anything
+// that can error out or touch the console.
+void Thread_ParallelFor(int count, const std::function<void(int)> &job);
@@ -3,33 +3,30 @@
 //
 
 #include "util.hpp"
+#include <unordered_map>
 
-auto findStringByName(std::string_view str) {
-    return std::find_if(edictStrings.begin(), edictStrings.end(), [str](const auto &eString) {
-        return eString.second == str;
-    });
-}
+// every string in the arena, keyed by its contents, so that equal strings
+// share one offset and lookups by name don't have to scan the arena
+static std::unordered_map<std::string_view, string_t> stringIndex;
 
-auto findStringByOffset(const unsigned long offset) {
-    return edictStrings.find(offset);
-}
+// function numbers by name, for spawn functions and saved function fields
+static std::unordered_map<std::string_view, func_t> functionIndex;
 
 auto stringExistsAtOffset(unsigned long offset) -> bool {
-    return findStringByOffset(offset) != edictStrings.end();
+    // empty strings count as missing, like the original !pr_strings[ofs] checks
+    return offset < static_cast<unsigned long>(pr_stringssize) && pr_strings[offset] != '\0';
 }
 
 auto getStringByOffset(const unsigned long offset) -> std::string_view {
-    auto stringIt = findStringByOffset(offset);
-    if (stringIt != edictStrings.end()) {
-        return stringIt->second;
+    if (offset < static_cast<unsigned long>(pr_stringssize)) {
+        return pr_strings + offset;
     }
     return {};
 }
 
 auto getOffsetByString(std::string_view name) -> unsigned long {
-    auto stringIt = findStringByName(name);
-    if (stringIt != edictStrings.end()) {
-        return stringIt->first;
+    if (const auto stringIt = stringIndex.find(name); stringIt != stringIndex.end()) {
+        return stringIt->second;
     }
     return 0;
 }
@@ -46,18 +43,24 @@ auto getEdictString(unsigned long offset, edict_s *edict) -> std::string_view {
     return getStringByOffset(*(string_t *) &((float *) &edict->v)[offset]);
 }
 
-auto getGlobalStringOffsetPair(unsigned long offset) -> std::pair<unsigned, std::string> {
-    return *findStringByOffset(*(string_t *) &pr_globals[offset]);
+auto getGlobalStringOffsetPair(unsigned long offset) -> std::pair<unsigned, std::string_view> {
+    const auto stringOffset = *(string_t *) &pr_globals[offset];
+    return {stringOffset, getStringByOffset(stringOffset)};
 }
 
-auto findFunctionByName(std::string_view name) {
-    return std::find_if(edictFunctions.begin(), edictFunctions.end(), [&name](const auto &item) {
-        return getStringByOffset(item.s_name) == name;
-    });
+void resetFunctionIndex() {
+    functionIndex.clear();
+    functionIndex.reserve(edictFunctions.size());
+    for (std::size_t i = 0; i < edictFunctions.size(); i++) {
+        functionIndex.try_emplace(getStringByOffset(edictFunctions[i].s_name), static_cast<func_t>(i));
+    }
 }
 
 auto getFunctionOffsetFromName(std::string_view name) -> unsigned long {
-    return static_cast<unsigned long>(std::distance(edictFunctions.begin(), findFunctionByName(name)));
+    if (const auto functionIt = functionIndex.find(name); functionIt != functionIndex.end()) {
+        return functionIt->second;
+    }
+    return 0;
 }
 
 /*
@@ -80,10 +83,43 @@ void fixNewLines(std::string& newstring) {
     }
 }
 
+/*
+=============
+resetStringTable
+
+Copies the progs string lump into a fresh hunk arena that has room left over
+for the strings created while the level runs. The arena goes away with the
+rest of the level's hunk memory, so runtime strings don't outlive the map.
+=============
+*/
+void resetStringTable(std::string_view lump) {
+    pr_maxstrings = static_cast<int>(lump.size()) + PR_DYNAMIC_STRING_SPACE;
+    pr_strings = hunkAllocName<char *>(pr_maxstrings, "strings");
+    pr_stringssize = static_cast<int>(lump.size());
+    std::memcpy(pr_strings, lump.data(), lump.size());
+    pr_strings[pr_maxstrings - 1] = '\0';
+
+    stringIndex.clear();
+    for (auto offset = 0; offset < pr_stringssize;) {
+        const std::string_view str = pr_strings + offset;
+        stringIndex.try_emplace(str, offset);
+        offset += static_cast<int>(str.length()) + 1;
+    }
+}
+
 auto newString(std::string string) -> unsigned long {
-    const auto lastIt = --edictStrings.end();
-    const auto offset = lastIt->first + lastIt->second.length() + 1;
     fixNewLines(string);
-    edictStrings[offset] = std::move(string);
+
+    if (const auto stringIt = stringIndex.find(string); stringIt != stringIndex.end()) {
+        return stringIt->second;
+    }
+
+    const auto offset = pr_stringssize;
+    if (offset + static_cast<int>(string.length()) + 1 >= pr_maxstrings)
+        Host_Error("newString: string space overflow");
+
+    std::memcpy(pr_strings + offset, string.c_str(), string.length() + 1);
+    pr_stringssize += static_cast<int>(string.length()) + 1;
+    stringIndex.emplace(std::string_view{pr_strings + offset, string.length()}, offset);
     return offset;
-}
\ No newline at end of file
+}
@@ -12,20 +12,14 @@ auto getGlobalString(unsigned long offset) -> std::string_view;
 
 auto getEdictString(unsigned long offset, edict_s *edict) -> std::string_view;
 
-auto getGlobalStringOffsetPair(unsigned long offset) -> std::pair<unsigned, std::string>;
+auto getGlobalStringOffsetPair(unsigned long offset) -> std::pair<unsigned, std::string_view>;
 
 auto getStringByOffset(unsigned long offset) -> std::string_view;
 
 auto getOffsetByString(std::string_view) -> unsigned long;
 
-auto findFunctionByName(std::string_view name);
-
 auto findFunctionByNameOffset(unsigned long offset);
 
-auto findStringByOffset(unsigned long offset);
-
-auto findStringByName(std::string_view str);
-
 auto getFunctionByName(std::string_view name) -> dfunction_t;
 
 auto getFunctionByNameOffset(unsigned long offset) -> dfunction_t;
@@ -34,6 +28,10 @@ auto getFunctionOffsetFromName(std::string_view name) -> unsigned long;
 
 auto stringExistsAtOffset(unsigned long offset) -> bool;
 
+void resetStringTable(std::string_view lump);
+
+void resetFunctionIndex();
+
 
 /*
  * Extended streambuf class to be used with std::string_view.
@@ -0,0 +1,192 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// vid_null.cpp -- video, input, renderer, screen and menu stubs for the
+// dedicated server, which never draws anything or reads a keyboard
+
+#include "quakedef.hpp"
+
+viddef_t vid;                // global video state
+unsigned short d_8to16table[256];
+
+void VID_ShiftPalette(unsigned char *palette) {
+}
+
+void VID_Init(unsigned char *palette) {
+}
+
+void VID_Shutdown() {
+}
+
+void D_BeginDirectRect(int x, int y, byte *pbitmap, int width, int height) {
+}
+
+void D_EndDirectRect(int x, int y, int width, int height) {
+}
+
+void D_FlushCaches() {
+}
+
+/*
+===============================================================================
+
+INPUT
+
+===============================================================================
+*/
+
+void IN_Init() {
+}
+
+void IN_Shutdown() {
+}
+
+void IN_Commands() {
+}
+
+void IN_Move(usercmd_t *cmd) {
+}
+
+void Sys_SendKeyEvents() {
+}
+
+/*
+===============================================================================
+
+RENDERER
+
+===============================================================================
+*/
+
+int r_pixbytes = 1;
+vec3 vup{}, vpn{}, vright{};
+vec3 r_origin{};
+refdef_t r_refdef;
+
+void R_Init() {
+}
+
+void R_RenderView() {
+}
+
+void R_InitSky(texture_t *mt) {
+}
+
+void R_AddEfrags(entity_t *ent) {
+}
+
+void R_RemoveEfrags(entity_t *ent) {
+}
+
+void R_NewMap() {
+}
+
+void R_ParseParticleEffect() {
+}
+
+void R_RunParticleEffect(vec3 org, vec3 dir, int color, int count) {
+}
+
+void R_RocketTrail(vec3 start, vec3 end, int type) {
+}
+
+void R_EntityParticles(entity_t *ent) {
+}
+
+void R_BlobExplosion(const vec3 org) {
+}
+
+void R_ParticleExplosion(const vec3 org) {
+}
+
+void R_ParticleExplosion2(const vec3 org, int colorStart, int colorLength) {
+}
+
+void R_LavaSplash(vec3 org) {
+}
+
+void R_TeleportSplash(vec3 org) {
+}
+
+void R_PushDlights() {
+}
+
+/*
+===============================================================================
+
+SCREEN
+
+===============================================================================
+*/
+
+int scr_copytop;
+int scr_copyeverything;
+float scr_con_current;
+cvar_t scr_viewsize = {"viewsize", "100", true};
+int scr_fullupdate;
+int clearnotify;
+vrect_t scr_vrect;
+qboolean scr_disabled_for_loading;
+float scr_centertime_off;
+
+void SCR_Init() {
+}
+
+void SCR_UpdateScreen() {
+}
+
+void SCR_CenterPrint(char *str) {
+}
+
+void SCR_BeginLoadingPlaque() {
+}
+
+void SCR_EndLoadingPlaque() {
+}
+
+/*
+===============================================================================
+
+MENU
+
+===============================================================================
+*/
+
+int m_state;
+int m_return_state;
+qboolean m_return_onerror;
+char m_return_reason[32];
+
+void M_Init() {
+}
+
+void M_Keydown(int key) {
+}
+
+void M_ToggleMenu_f() {
+}
+
+void M_Menu_Main_f() {
+}
+
+void M_Menu_Quit_f() {
+}
+
+void M_DrawPic(int x, int y, qpic_t *pic) {
+}
@@ -464,12 +464,3 @@ void IN_Move(usercmd_t *cmd) {
     }
     mouse_x = mouse_y = 0.0;
 }
-
-/*
-================
-Sys_ConsoleInput
-================
-*/
-auto Sys_ConsoleInput() -> char * {
-    return nullptr;
-}
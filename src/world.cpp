@@ -19,6 +19,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // world.c -- world query functions
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include "quakedef.hpp"
@@ -54,9 +55,11 @@ HULL BOXES
 */
 
 
-static hull_t box_hull;
-static dclipnode_t box_clipnodes[6];
-static mplane_t box_planes[6];
+// one box hull for each thread, so moves can be traced in parallel
+static thread_local hull_t box_hull;
+static thread_local dclipnode_t box_clipnodes[6];
+static thread_local mplane_t box_planes[6];
+alignas(64) static thread_local mclipnode_t box_nodes[6];
 
 /*
 ===================
@@ -88,8 +91,14 @@ void SV_InitBoxHull() {
 
         box_planes[i].type = i >> 1;
         box_planes[i].normal[i >> 1] = 1;
+
+        box_nodes[i].normal = box_planes[i].normal;
+        box_nodes[i].type = box_planes[i].type;
+        box_nodes[i].children[0] = box_clipnodes[i].children[0];
+        box_nodes[i].children[1] = box_clipnodes[i].children[1];
     }
 
+    box_hull.nodes = box_nodes;
 }
 
 
@@ -102,6 +111,9 @@ BSP trees instead of being compared directly.
 ===================
 */
 inline auto SV_HullForBox(vec3 mins, vec3 maxs) -> hull_t * {
+    if (!box_hull.nodes)
+        SV_InitBoxHull();    // first box on a worker thread
+
     box_planes[0].dist = maxs[0];
     box_planes[1].dist = mins[0];
     box_planes[2].dist = maxs[1];
@@ -109,6 +121,9 @@ inline auto SV_HullForBox(vec3 mins, vec3 maxs) -> hull_t * {
     box_planes[4].dist = maxs[2];
     box_planes[5].dist = mins[2];
 
+    for (int i = 0; i < 6; i++)
+        box_nodes[i].dist = box_planes[i].dist;
+
     return &box_hull;
 }
 
@@ -171,24 +186,53 @@ ENTITY AREA CHECKING
 ===============================================================================
 */
 
+// 0 sizes the area tree to the map, otherwise its depth
+cvar_t sv_areadepth = {"sv_areadepth", "0"};
+
+// a trigger touches an entity at most once a frame, however often it's linked
+cvar_t sv_touchonce = {"sv_touchonce", "1"};
+
+#define    AREA_MAX_DEPTH    10
+#define    AREA_MIN_SIZE    384        // nodes smaller than this aren't split when sizing to the map
+
+// the entities linked to one node, with their boxes beside them so the
+// overlap tests run through arrays instead of the edicts
+using arealist_t = struct arealist_s {
+    struct areanode_s *node;    // the node it belongs to, NULL if none
+    qboolean triggers;
+    std::vector<edict_t *> edicts;
+    std::vector<float> absmin[3];
+    std::vector<float> absmax[3];
+};
+
 using areanode_t = struct areanode_s {
     int axis;        // -1 = leaf node
     float dist;
+    struct areanode_s *parent;
     struct areanode_s *children[2];
-    link_t trigger_edicts;
-    link_t solid_edicts;
+    int numtriggers;        // linked here and in all the nodes below
+    arealist_t trigger_edicts;
+    arealist_t solid_edicts;
 };
 
-#define    AREA_DEPTH    4
-#define    AREA_NODES    32
-
-static areanode_t sv_areanodes[AREA_NODES];
-static int sv_numareanodes;
+static std::vector<areanode_t> sv_areanodes;
+static int sv_areanodedepth;
+static int sv_areageneration;        // bumped whenever an entity is linked or unlinked
+
+static auto SV_AreaOverlaps(const arealist_t *list, std::size_t i, const vec3 &mins, const vec3 &maxs) -> bool {
+    return !(mins[0] > list->absmax[0][i]
+             || mins[1] > list->absmax[1][i]
+             || mins[2] > list->absmax[2][i]
+             || maxs[0] < list->absmin[0][i]
+             || maxs[1] < list->absmin[1][i]
+             || maxs[2] < list->absmin[2][i]);
+}
 
 /*
 ===============
 SV_CreateAreaNode
 
+Splits the longest side, height included, until the depth is reached
 ===============
 */
 auto SV_CreateAreaNode(int depth, vec3 mins, vec3 maxs) -> areanode_t * {
@@ -196,23 +240,24 @@ auto SV_CreateAreaNode(int depth, vec3 mins, vec3 maxs) -> areanode_t * {
     vec3 size;
     vec3 mins1, maxs1, mins2, maxs2;
 
-    anode = &sv_areanodes[sv_numareanodes];
-    sv_numareanodes++;
-
-    ClearLink(&anode->trigger_edicts);
-    ClearLink(&anode->solid_edicts);
+    anode = &sv_areanodes.emplace_back();
+    anode->trigger_edicts.node = anode;
+    anode->trigger_edicts.triggers = true;
+    anode->solid_edicts.node = anode;
 
-    if (depth == AREA_DEPTH) {
+    size = maxs - mins;
+    if (depth == sv_areanodedepth) {
         anode->axis = -1;
         anode->children[0] = anode->children[1] = nullptr;
         return anode;
     }
 
-    size = maxs - mins;
-    if (size[0] > size[1])
+    if (size[0] >= size[1] && size[0] >= size[2])
         anode->axis = 0;
-    else
+    else if (size[1] >= size[2])
         anode->axis = 1;
+    else
+        anode->axis = 2;
 
     anode->dist = 0.5 * (maxs[anode->axis] + mins[anode->axis]);
     mins1 = mins;
@@ -224,10 +269,35 @@ auto SV_CreateAreaNode(int depth, vec3 mins, vec3 maxs) -> areanode_t * {
 
     anode->children[0] = SV_CreateAreaNode(depth + 1, mins2, maxs2);
     anode->children[1] = SV_CreateAreaNode(depth + 1, mins1, maxs1);
+    anode->children[0]->parent = anode->children[1]->parent = anode;
 
     return anode;
 }
 
+/*
+===============
+SV_AreaDepth
+
+How deep the tree goes for the world, from sv_areadepth or the size of
+the map: deep enough for the leaf nodes to be about AREA_MIN_SIZE across
+===============
+*/
+static auto SV_AreaDepth() -> int {
+    if (sv_areadepth.value >= 1)
+        return std::min(static_cast<int>(sv_areadepth.value), AREA_MAX_DEPTH);
+
+    vec3 size = sv.worldmodel->maxs - sv.worldmodel->mins;
+    int depth = 0;
+    while (depth < AREA_MAX_DEPTH) {
+        const auto axis = size[0] >= size[1] && size[0] >= size[2] ? 0 : size[1] >= size[2] ? 1 : 2;
+        if (size[axis] <= AREA_MIN_SIZE)
+            break;
+        size[axis] *= 0.5;
+        depth++;
+    }
+    return depth;
+}
+
 /*
 ===============
 SV_ClearWorld
@@ -237,9 +307,13 @@ SV_ClearWorld
 void SV_ClearWorld() {
     SV_InitBoxHull();
 
-    memset(sv_areanodes, 0, sizeof(sv_areanodes));
-    sv_numareanodes = 0;
+    sv_areanodedepth = SV_AreaDepth();
+    sv_areageneration++;
+    sv_areanodes.clear();
+    sv_areanodes.reserve((2 << sv_areanodedepth) - 1);        // children are pointed to
     SV_CreateAreaNode(0, sv.worldmodel->mins, sv.worldmodel->maxs);
+
+    SV_ClearTouches();
 }
 
 
@@ -250,26 +324,213 @@ SV_UnlinkEdict
 ===============
 */
 void SV_UnlinkEdict(edict_t *ent) {
-    if (!ent->area.prev)
+    auto *list = ent->arealist;
+    if (!list)
         return;        // not linked in anywhere
-    RemoveLink(&ent->area);
-    ent->area.prev = ent->area.next = nullptr;
+
+    ED_CHANGED(ent);
+
+    // move the last entity into the hole
+    const auto slot = static_cast<std::size_t>(ent->areaslot);
+    const auto last = list->edicts.size() - 1;
+    if (slot != last) {
+        list->edicts[slot] = list->edicts[last];
+        list->edicts[slot]->areaslot = static_cast<int>(slot);
+        for (int i = 0; i < 3; i++) {
+            list->absmin[i][slot] = list->absmin[i][last];
+            list->absmax[i][slot] = list->absmax[i][last];
+        }
+    }
+
+    list->edicts.pop_back();
+    for (int i = 0; i < 3; i++) {
+        list->absmin[i].pop_back();
+        list->absmax[i].pop_back();
+    }
+    ent->arealist = nullptr;
+    sv_areageneration++;
+
+    if (list->triggers) {
+        for (auto *node = list->node; node; node = node->parent)
+            node->numtriggers--;
+    }
+}
+
+static void SV_AreaLink(edict_t *ent, arealist_t *list) {
+    ent->arealist = list;
+    ent->areaslot = static_cast<int>(list->edicts.size());
+    sv_areageneration++;
+
+    if (list->triggers) {
+        for (auto *node = list->node; node; node = node->parent)
+            node->numtriggers++;
+    }
+
+    list->edicts.push_back(ent);
+    for (int i = 0; i < 3; i++) {
+        list->absmin[i].push_back(ent->v.absmin[i]);
+        list->absmax[i].push_back(ent->v.absmax[i]);
+    }
 }
 
 
+/*
+===============
+SV_AreaContains
+
+True if point is inside the box ent is linked with
+===============
+*/
+auto SV_AreaContains(const edict_t *ent, const vec3 &point) -> bool {
+    const auto *list = ent->arealist;
+    if (!list)
+        return false;
+
+    for (int i = 0; i < 3; i++) {
+        if (point[i] < list->absmin[i][ent->areaslot] || point[i] > list->absmax[i][ent->areaslot])
+            return false;
+    }
+    return true;
+}
+
+static void SV_AreaEdictsNode(const areanode_t *node, const vec3 &mins, const vec3 &maxs, std::vector<int> &nums) {
+    for (const auto *list: {&node->solid_edicts, &node->trigger_edicts}) {
+        for (std::size_t i = 0; i < list->edicts.size(); i++) {
+            if (SV_AreaOverlaps(list, i, mins, maxs))
+                nums.push_back(NUM_FOR_EDICT(list->edicts[i]));
+        }
+    }
+
+    if (node->axis == -1)
+        return;
+
+    if (maxs[node->axis] > node->dist)
+        SV_AreaEdictsNode(node->children[0], mins, maxs, nums);
+    if (mins[node->axis] < node->dist)
+        SV_AreaEdictsNode(node->children[1], mins, maxs, nums);
+}
+
+/*
+===============
+SV_AreaEdicts
+
+Adds the numbers of all the linked edicts whose boxes touch mins / maxs
+===============
+*/
+void SV_AreaEdicts(const vec3 &mins, const vec3 &maxs, std::vector<int> &nums) {
+    SV_AreaEdictsNode(sv_areanodes.data(), mins, maxs, nums);
+}
+
+
+/*
+===============================================================================
+
+TRIGGER TOUCHES
+
+An entity is linked with touches whenever it moves, and can be linked
+several times in one frame: by its own physics, by a pusher, by
+force_retouch. Each entity keeps the triggers that have touched it this
+frame, and with sv_touchonce a trigger doesn't touch it again until the
+next one.
+
+===============================================================================
+*/
+
+using touchframe_t = struct {
+    double time;        // sv.time of the frame the triggers are from
+    int serial;            // bumped every time the edict is freed
+    std::vector<std::pair<int, int>> triggers;    // edict number and serial
+};
+
+static std::vector<touchframe_t> sv_touchframes;        // by edict number
+
+/*
+====================
+SV_ClearTouches
+====================
+*/
+void SV_ClearTouches() {
+    sv_touchframes.clear();
+}
+
+static auto SV_TouchFrame(int num) -> touchframe_t * {
+    if (num >= static_cast<int>(sv_touchframes.size()))
+        sv_touchframes.resize(sv.max_edicts);
+    return &sv_touchframes[num];
+}
+
+/*
+====================
+SV_ForgetTouches
+
+An edict can be freed and handed out again in the same frame. The serial
+keeps the new one from inheriting the old one's touches, either way round.
+====================
+*/
+void SV_ForgetTouches(edict_t *ent) {
+    auto *frame = SV_TouchFrame(NUM_FOR_EDICT(ent));
+    frame->triggers.clear();
+    frame->serial++;
+}
+
+// records the touch, and returns true if it was already made this frame
+static auto SV_TouchedThisFrame(edict_t *ent, edict_t *trigger) -> bool {
+    auto *frame = SV_TouchFrame(NUM_FOR_EDICT(ent));
+    if (frame->time != sv.time) {
+        frame->time = sv.time;
+        frame->triggers.clear();
+    }
+
+    const auto triggernum = NUM_FOR_EDICT(trigger);
+    const std::pair key{triggernum, SV_TouchFrame(triggernum)->serial};
+    if (std::find(frame->triggers.begin(), frame->triggers.end(), key) != frame->triggers.end())
+        return true;
+
+    frame->triggers.push_back(key);
+    return false;
+}
+
 /*
 ====================
 SV_TouchLinks
+
+Gathers the triggers ent's box is in before running any of them, as touch
+functions can relink entities and change the lists
 ====================
 */
-void SV_TouchLinks(const edict_t *ent, const areanode_t *node) {
+static std::vector<edict_t *> sv_touched;        // a stack, touch functions can touch more
+
+static void SV_FindTouches(const edict_t *ent, const areanode_t *node) {
+    if (!node->numtriggers)
+        return;        // nothing to touch down here
+
+    const auto *list = &node->trigger_edicts;
+    for (std::size_t i = 0; i < list->edicts.size(); i++) {
+        if (list->edicts[i] != ent && SV_AreaOverlaps(list, i, ent->v.absmin, ent->v.absmax))
+            sv_touched.push_back(list->edicts[i]);
+    }
+
+// recurse down both sides
+    if (node->axis == -1)
+        return;
+
+    if (ent->v.absmax[node->axis] > node->dist)
+        SV_FindTouches(ent, node->children[0]);
+    if (ent->v.absmin[node->axis] < node->dist)
+        SV_FindTouches(ent, node->children[1]);
+}
+
+static void SV_TouchLinks(edict_t *ent, const areanode_t *node) {
+    const auto base = sv_touched.size();
+
+    SV_FindTouches(ent, node);
+
 // touch linked edicts
-    for (link_t *l = node->trigger_edicts.next, *next = l->next;
-         l != &node->trigger_edicts;
-         l = next, next = l->next) {
-        auto touch = (EDICT_FROM_AREA(l));
+    for (auto i = base; i < sv_touched.size(); i++) {
+        auto *touch = sv_touched[i];
 
-        if (touch == ent)
+        // earlier touches may have moved or removed either of them
+        if (touch->free)
             continue;
         if (!touch->v.touch || touch->v.solid != SOLID_TRIGGER)
             continue;
@@ -280,6 +541,8 @@ void SV_TouchLinks(const edict_t *ent, const areanode_t *node) {
             || ent->v.absmax[1] < touch->v.absmin[1]
             || ent->v.absmax[2] < touch->v.absmin[2])
             continue;
+        if (sv_touchonce.value && SV_TouchedThisFrame(ent, touch))
+            continue;
 
         const int old_self = pr_global_struct->self;
         const int old_other = pr_global_struct->other;
@@ -293,14 +556,7 @@ void SV_TouchLinks(const edict_t *ent, const areanode_t *node) {
         pr_global_struct->other = old_other;
     }
 
-// recurse down both sides
-    if (node->axis == -1)
-        return;
-
-    if (ent->v.absmax[node->axis] > node->dist)
-        SV_TouchLinks(ent, node->children[0]);
-    if (ent->v.absmin[node->axis] < node->dist)
-        SV_TouchLinks(ent, node->children[1]);
+    sv_touched.resize(base);
 }
 
 
@@ -348,24 +604,11 @@ void SV_FindTouchedLeafs(edict_t *ent, mnode_t *node) {
 
 /*
 ===============
-SV_LinkEdict
+SV_SetAbsBox
 
 ===============
 */
-void SV_LinkEdict(edict_t *ent, qboolean touch_triggers) {
-    areanode_t *node = nullptr;
-
-    if (ent->area.prev)
-        SV_UnlinkEdict(ent);    // unlink from old position
-
-    if (ent == sv.edicts)
-        return;        // don't add the world
-
-    if (ent->free)
-        return;
-
-// set the abs box
-
+static void SV_SetAbsBox(edict_t *ent) {
 #ifdef QUAKE2
     if (ent->v.solid == SOLID_BSP &&
     (ent->v.angles[0] || ent->v.angles[1] || ent->v.angles[2]) )
@@ -414,6 +657,29 @@ void SV_LinkEdict(edict_t *ent, qboolean touch_triggers) {
         ent->v.absmax[1] += 1;
         ent->v.absmax[2] += 1;
     }
+}
+
+/*
+===============
+SV_LinkEdict
+
+===============
+*/
+void SV_LinkEdict(edict_t *ent, qboolean touch_triggers) {
+    areanode_t *node = nullptr;
+
+    ED_CHANGED(ent);
+
+    if (ent->arealist)
+        SV_UnlinkEdict(ent);    // unlink from old position
+
+    if (ent == sv.edicts)
+        return;        // don't add the world
+
+    if (ent->free)
+        return;
+
+    SV_SetAbsBox(ent);
 
 // link to PVS leafs
     ent->num_leafs = 0;
@@ -424,7 +690,7 @@ void SV_LinkEdict(edict_t *ent, qboolean touch_triggers) {
         return;
 
 // find the first node that the ent's box crosses
-    node = sv_areanodes;
+    node = sv_areanodes.data();
     while (true) {
         if (node->axis == -1)
             break;
@@ -439,13 +705,42 @@ void SV_LinkEdict(edict_t *ent, qboolean touch_triggers) {
 // link it in	
 
     if (ent->v.solid == SOLID_TRIGGER)
-        InsertLinkBefore(&ent->area, &node->trigger_edicts);
+        SV_AreaLink(ent, &node->trigger_edicts);
     else
-        InsertLinkBefore(&ent->area, &node->solid_edicts);
+        SV_AreaLink(ent, &node->solid_edicts);
 
 // if touch_triggers, touch all entities at this node and decend for more
     if (touch_triggers)
-        SV_TouchLinks(ent, sv_areanodes);
+        SV_TouchLinks(ent, sv_areanodes.data());
+}
+
+/*
+===============
+SV_RetouchEdict
+
+Runs the touches of the triggers ent is in, relinking it first only if it
+has moved or changed since it was linked
+===============
+*/
+void SV_RetouchEdict(edict_t *ent) {
+    const auto *list = ent->arealist;
+
+    if (!list || ent->free || ent->v.solid == SOLID_NOT
+        || list->triggers != (ent->v.solid == SOLID_TRIGGER)) {
+        SV_LinkEdict(ent, true);
+        return;
+    }
+
+    SV_SetAbsBox(ent);
+    for (int i = 0; i < 3; i++) {
+        if (ent->v.absmin[i] != list->absmin[i][ent->areaslot]
+            || ent->v.absmax[i] != list->absmax[i][ent->areaslot]) {
+            SV_LinkEdict(ent, true);
+            return;
+        }
+    }
+
+    SV_TouchLinks(ent, sv_areanodes.data());
 }
 
 
@@ -468,20 +763,18 @@ SV_HullPointContents
 */
 auto SV_HullPointContents(hull_t *hull, int num, vec3 p) -> int {
     float d = NAN;
-    dclipnode_t *node = nullptr;
-    mplane_t *plane = nullptr;
+    const mclipnode_t *node = nullptr;
 
     while (num >= 0) {
         if (num < hull->firstclipnode || num > hull->lastclipnode)
             Sys_Error("SV_HullPointContents: bad node number");
 
-        node = hull->clipnodes + num;
-        plane = hull->planes + node->planenum;
+        node = hull->nodes + num;
 
-        if (plane->type < 3)
-            d = p[plane->type] - plane->dist;
+        if (node->type < 3)
+            d = p[node->type] - node->dist;
         else
-            d = glm::dot (plane->normal, p) - plane->dist;
+            d = glm::dot (node->normal, p) - node->dist;
         if (d < 0)
             num = node->children[1];
         else
@@ -545,25 +838,95 @@ LINE TESTING IN HULLS
 // 1/32 epsilon to keep floating point happy
 #define    DIST_EPSILON    (0.03125)
 
+#define    HULL_STACK    256
+
+// a node a trace crosses, kept while the part on the near side is traced
+using hullsplit_t = struct {
+    const mclipnode_t *node;
+    int side;        // the side p1 is on
+    float frac;
+    float p1f, midf, p2f;
+    vec3 p1, mid, p2;
+};
+
+thread_local int *sv_tracebackups;
+
 /*
 ==================
-SV_RecursiveHullCheck
+SV_HullCheck
+
+Traces p1 to p2 through the hull from node num. p1f and p2f are the trace
+fractions of p1 and p2. Returns false once the trace has stopped.
 
+Walks the tree depth first with an explicit stack, near side first: a part
+of the line ending up in an empty leaf pops back to the last node crossed,
+and carries on past it unless the far side is solid at the crossing.
 ==================
 */
-auto
-SV_RecursiveHullCheck(hull_t *hull, int num, float p1f, float p2f, vec3 p1, vec3 p2, trace_t *trace) -> qboolean {
-    dclipnode_t *node = nullptr;
-    mplane_t *plane = nullptr;
-    float t1 = NAN, t2 = NAN;
-    float frac = NAN;
-    int i = 0;
-    vec3 mid;
-    int side = 0;
-    float midf = NAN;
+auto SV_HullCheck(hull_t *hull, int num, float p1f, float p2f, vec3 p1, vec3 p2, trace_t *trace) -> qboolean {
+    hullsplit_t stack[HULL_STACK];
+    int depth = 0;
+    const auto *nodes = hull->nodes;
+
+    while (true) {
+        while (num >= 0) {
+            if (num < hull->firstclipnode || num > hull->lastclipnode)
+                Sys_Error("SV_HullCheck: bad node number");
+
+//
+// find the point distances
+//
+            const auto *node = nodes + num;
+            float t1 = NAN, t2 = NAN;
+
+            if (node->type < 3) {
+                t1 = p1[node->type] - node->dist;
+                t2 = p2[node->type] - node->dist;
+            } else {
+                t1 = glm::dot (node->normal, p1) - node->dist;
+                t2 = glm::dot (node->normal, p2) - node->dist;
+            }
+
+            if (t1 >= 0 && t2 >= 0) {
+                num = node->children[0];
+                continue;
+            }
+            if (t1 < 0 && t2 < 0) {
+                num = node->children[1];
+                continue;
+            }
+
+// put the crosspoint DIST_EPSILON pixels on the near side
+            float frac = NAN;
+            if (t1 < 0)
+                frac = (t1 + DIST_EPSILON) / (t1 - t2);
+            else
+                frac = (t1 - DIST_EPSILON) / (t1 - t2);
+            if (frac < 0)
+                frac = 0;
+            if (frac > 1)
+                frac = 1;
+
+            if (depth == HULL_STACK)
+                Sys_Error("SV_HullCheck: hull too deep");
+            auto *split = &stack[depth++];
+            split->node = node;
+            split->side = (t1 < 0);
+            split->frac = frac;
+            split->p1f = p1f;
+            split->midf = p1f + (p2f - p1f) * frac;
+            split->p2f = p2f;
+            split->p1 = p1;
+            split->mid = p1 + frac * (p2 - p1);
+            split->p2 = p2;
+
+// move up to the node
+            num = node->children[split->side];
+            p2f = split->midf;
+            p2 = split->mid;
+        }
 
 // check for empty
-    if (num < 0) {
         if (num != CONTENTS_SOLID) {
             trace->allsolid = false;
             if (num == CONTENTS_EMPTY)
@@ -572,101 +935,91 @@ SV_RecursiveHullCheck(hull_t *hull, int num, float p1f, float p2f, vec3 p1, vec3
                 trace->inwater = true;
         } else
             trace->startsolid = true;
-        return true;        // empty
-    }
-
-    if (num < hull->firstclipnode || num > hull->lastclipnode)
-        Sys_Error("SV_RecursiveHullCheck: bad node number");
-
-//
-// find the point distances
-//
-    node = hull->clipnodes + num;
-    plane = hull->planes + node->planenum;
-
-    if (plane->type < 3) {
-        t1 = p1[plane->type] - plane->dist;
-        t2 = p2[plane->type] - plane->dist;
-    } else {
-        t1 = glm::dot (plane->normal, p1) - plane->dist;
-        t2 = glm::dot (plane->normal, p2) - plane->dist;
-    }
-
-#if 1
-    if (t1 >= 0 && t2 >= 0)
-        return SV_RecursiveHullCheck(hull, node->children[0], p1f, p2f, p1, p2, trace);
-    if (t1 < 0 && t2 < 0)
-        return SV_RecursiveHullCheck(hull, node->children[1], p1f, p2f, p1, p2, trace);
-#else
-    if ( (t1 >= DIST_EPSILON && t2 >= DIST_EPSILON) || (t2 > t1 && t1 >= 0) )
-        return SV_RecursiveHullCheck (hull, node->children[0], p1f, p2f, p1, p2, trace);
-    if ( (t1 <= -DIST_EPSILON && t2 <= -DIST_EPSILON) || (t2 < t1 && t1 <= 0) )
-        return SV_RecursiveHullCheck (hull, node->children[1], p1f, p2f, p1, p2, trace);
-#endif
-
-// put the crosspoint DIST_EPSILON pixels on the near side
-    if (t1 < 0)
-        frac = (t1 + DIST_EPSILON) / (t1 - t2);
-    else
-        frac = (t1 - DIST_EPSILON) / (t1 - t2);
-    if (frac < 0)
-        frac = 0;
-    if (frac > 1)
-        frac = 1;
-
-    midf = p1f + (p2f - p1f) * frac;
-    mid = p1 + frac * (p2 - p1);
 
-    side = (t1 < 0);
+        if (!depth)
+            return true;        // empty
 
-// move up to the node
-    if (!SV_RecursiveHullCheck(hull, node->children[side], p1f, midf, p1, mid, trace))
-        return false;
+        const auto *split = &stack[--depth];
+        const auto *node = split->node;
 
 #ifdef PARANOID
-    if (SV_HullPointContents(hull, node->children[side], mid)
-        == CONTENTS_SOLID) {
-//        Con_Printf("mid PointInHullSolid\n");
-        return false;
-    }
+        if (SV_HullPointContents(hull, node->children[split->side], split->mid) == CONTENTS_SOLID) {
+//            Con_Printf("mid PointInHullSolid\n");
+            return false;
+        }
 #endif
 
-    if (SV_HullPointContents(hull, node->children[side ^ 1], mid)
-        != CONTENTS_SOLID)
+        if (SV_HullPointContents(hull, node->children[split->side ^ 1], split->mid) != CONTENTS_SOLID) {
 // go past the node
-        return SV_RecursiveHullCheck(hull, node->children[side ^ 1], midf, p2f, mid, p2, trace);
+            num = node->children[split->side ^ 1];
+            p1f = split->midf;
+            p2f = split->p2f;
+            p1 = split->mid;
+            p2 = split->p2;
+            continue;
+        }
 
-    if (trace->allsolid)
-        return false;        // never got out of the solid area
+        if (trace->allsolid)
+            return false;        // never got out of the solid area
 
 //==================
 // the other side of the node is solid, this is the impact point
 //==================
-    if (!side) {
-        trace->plane.normal = plane->normal;
-        trace->plane.dist = plane->dist;
-    } else {
-        trace->plane.normal = vec3_origin - plane->normal;
-        trace->plane.dist = -plane->dist;
-    }
+        if (!split->side) {
+            trace->plane.normal = node->normal;
+            trace->plane.dist = node->dist;
+        } else {
+            trace->plane.normal = vec3_origin - node->normal;
+            trace->plane.dist = -node->dist;
+        }
 
-    while (SV_HullPointContents(hull, hull->firstclipnode, mid)
-           == CONTENTS_SOLID) { // shouldn't really happen, but does occasionally
-        frac -= 0.1;
-        if (frac < 0) {
-            trace->fraction = midf;
-            trace->endpos = mid;
-            Con_DPrintf("backup past 0\n");
-            return false;
+        auto frac = split->frac;
+        auto midf = split->midf;
+        auto mid = split->mid;
+        while (SV_HullPointContents(hull, hull->firstclipnode, mid)
+               == CONTENTS_SOLID) { // shouldn't really happen, but does occasionally
+            frac -= 0.1;
+            if (frac < 0) {
+                trace->fraction = midf;
+                trace->endpos = mid;
+                if (sv_tracebackups)
+                    ++*sv_tracebackups;
+                else
+                    Con_DPrintf("backup past 0\n");
+                return false;
+            }
+            midf = split->p1f + (split->p2f - split->p1f) * frac;
+            mid = split->p1 + frac * (split->p2 - split->p1);
         }
-        midf = p1f + (p2f - p1f) * frac;
-        mid = p1 + frac * (p2 - p1);
+
+        trace->fraction = midf;
+        trace->endpos = mid;
+
+        return false;
     }
+}
 
-    trace->fraction = midf;
-    trace->endpos = mid;
+/*
+==================
+SV_HullCheckBatch
 
-    return false;
+Traces count lines through the same hull, with the hull placed at offset,
+the same way SV_ClipMoveToEntity traces one
+==================
+*/
+void SV_HullCheckBatch(hull_t *hull, int count, const vec3 *starts, const vec3 *ends, vec3 offset, trace_t *traces) {
+    for (int i = 0; i < count; i++) {
+        auto *trace = &traces[i];
+
+        memset(trace, 0, sizeof(*trace));
+        trace->fraction = 1;
+        trace->allsolid = true;
+        trace->endpos = ends[i];
+
+        SV_HullCheck(hull, hull->firstclipnode, 0, 1, starts[i] - offset, ends[i] - offset, trace);
+
+        if (trace->fraction != 1) trace->endpos = trace->endpos + offset;
+    }
 }
 
 
@@ -720,7 +1073,7 @@ auto SV_ClipMoveToEntity(edict_t *ent, vec3 &start, vec3 mins, vec3 maxs, vec3 &
 #endif
 
 // trace a line through the apropriate clipping hull
-    SV_RecursiveHullCheck(hull, hull->firstclipnode, 0, 1, start_l, end_l, &trace);
+    SV_HullCheck(hull, hull->firstclipnode, 0, 1, start_l, end_l, &trace);
 
 #ifdef QUAKE2
     // rotate endpos back to world frame of reference
@@ -763,20 +1116,22 @@ auto SV_ClipMoveToEntity(edict_t *ent, vec3 &start, vec3 mins, vec3 maxs, vec3 &
 
 /*
 ====================
-SV_ClipToLinks
+SV_ClipToList
 
-Mins and maxs enclose the entire area swept by the move
+Returns false if the move is stuck in a solid and nothing else needs checking
 ====================
 */
-void SV_ClipToLinks(areanode_t *node, moveclip_t *clip) {
-    link_t *l = nullptr, *next = nullptr;
+static auto SV_ClipToList(const arealist_t *list, moveclip_t *clip) -> bool {
     edict_t *touch = nullptr;
     trace_t trace;
 
 // touch linked edicts
-    for (l = node->solid_edicts.next; l != &node->solid_edicts; l = next) {
-        next = l->next;
-        touch = EDICT_FROM_AREA(l);
+    for (std::size_t i = 0; i < list->edicts.size(); i++) {
+        // the box test first, it rejects most and doesn't need the edict
+        if (!SV_AreaOverlaps(list, i, clip->boxmins, clip->boxmaxs))
+            continue;
+
+        touch = list->edicts[i];
         if (touch->v.solid == SOLID_NOT)
             continue;
         if (touch == clip->passedict)
@@ -787,20 +1142,12 @@ void SV_ClipToLinks(areanode_t *node, moveclip_t *clip) {
         if (clip->type == MOVE_NOMONSTERS && touch->v.solid != SOLID_BSP)
             continue;
 
-        if (clip->boxmins[0] > touch->v.absmax[0]
-            || clip->boxmins[1] > touch->v.absmax[1]
-            || clip->boxmins[2] > touch->v.absmax[2]
-            || clip->boxmaxs[0] < touch->v.absmin[0]
-            || clip->boxmaxs[1] < touch->v.absmin[1]
-            || clip->boxmaxs[2] < touch->v.absmin[2])
-            continue;
-
         if (clip->passedict && clip->passedict->v.size[0] && !touch->v.size[0])
             continue;    // points never interact
 
         // might intersect, so do an exact clip
         if (clip->trace.allsolid)
-            return;
+            return false;
         if (clip->passedict) {
             if (PROG_TO_EDICT(touch->v.owner) == clip->passedict)
                 continue;    // don't clip against own missiles
@@ -824,6 +1171,20 @@ void SV_ClipToLinks(areanode_t *node, moveclip_t *clip) {
             clip->trace.startsolid = true;
     }
 
+    return true;
+}
+
+/*
+====================
+SV_ClipToLinks
+
+Mins and maxs enclose the entire area swept by the move
+====================
+*/
+void SV_ClipToLinks(areanode_t *node, moveclip_t *clip) {
+    if (!SV_ClipToList(&node->solid_edicts, clip))
+        return;
+
 // recurse down both sides
     if (node->axis == -1)
         return;
@@ -835,6 +1196,88 @@ void SV_ClipToLinks(areanode_t *node, moveclip_t *clip) {
 }
 
 
+/*
+===============================================================================
+
+GATHERED MOVES
+
+Traces close to each other can share one walk of the area tree. The solid
+entities whose boxes touch an area around all of them are gathered, in the
+order the tree walk finds them, and a move whose box is inside that area
+checks the gathered list instead. The list is only good until something is
+linked or unlinked.
+
+===============================================================================
+*/
+
+static arealist_t sv_gathered;
+static vec3 sv_gathermins, sv_gathermaxs;
+static int sv_gathergeneration = -1;
+
+static void SV_GatherLinks(const areanode_t *node) {
+    const auto *list = &node->solid_edicts;
+    for (std::size_t i = 0; i < list->edicts.size(); i++) {
+        if (!SV_AreaOverlaps(list, i, sv_gathermins, sv_gathermaxs))
+            continue;
+
+        sv_gathered.edicts.push_back(list->edicts[i]);
+        for (int j = 0; j < 3; j++) {
+            sv_gathered.absmin[j].push_back(list->absmin[j][i]);
+            sv_gathered.absmax[j].push_back(list->absmax[j][i]);
+        }
+    }
+
+// recurse down both sides
+    if (node->axis == -1)
+        return;
+
+    if (sv_gathermaxs[node->axis] > node->dist)
+        SV_GatherLinks(node->children[0]);
+    if (sv_gathermins[node->axis] < node->dist)
+        SV_GatherLinks(node->children[1]);
+}
+
+/*
+====================
+SV_GatherMoves
+
+Gathers the entities for moves that stay inside boxmins / boxmaxs
+====================
+*/
+void SV_GatherMoves(vec3 boxmins, vec3 boxmaxs) {
+    sv_gathered.edicts.clear();
+    for (int i = 0; i < 3; i++) {
+        sv_gathered.absmin[i].clear();
+        sv_gathered.absmax[i].clear();
+    }
+
+    sv_gathermins = boxmins;
+    sv_gathermaxs = boxmaxs;
+    SV_GatherLinks(sv_areanodes.data());
+    sv_gathergeneration = sv_areageneration;
+}
+
+/*
+====================
+SV_ClearGather
+====================
+*/
+void SV_ClearGather() {
+    sv_gathergeneration = -1;
+}
+
+static auto SV_GatherCovers(const moveclip_t *clip) -> bool {
+    if (sv_gathergeneration != sv_areageneration)
+        return false;
+
+    for (int i = 0; i < 3; i++) {
+        if (clip->boxmins[i] < sv_gathermins[i] || clip->boxmaxs[i] > sv_gathermaxs[i])
+            return false;
+    }
+    return true;
+}
+
+
 /*
 ==================
 SV_MoveBounds
@@ -860,38 +1303,112 @@ inline void SV_MoveBounds(vec3 start, vec3 mins, vec3 maxs, vec3 end, vec3 &boxm
 
 /*
 ==================
-SV_Move
+SV_ClipMoveToEntities
+
+Clips a move already clipped to the world against the solid entities
 ==================
 */
-auto SV_Move(vec3 &start, vec3 mins, vec3 maxs, vec3 &end, int type, edict_t *passedict) -> trace_t {
-    moveclip_t clip{};
-
-// clip to world
-    clip.trace = SV_ClipMoveToEntity(sv.edicts, start, mins, maxs, end);
-
-    clip.start = start;
-    clip.end = end;
-    clip.mins = mins;
-    clip.maxs = maxs;
-    clip.type = type;
-    clip.passedict = passedict;
+static void SV_ClipMoveToEntities(moveclip_t *clip, vec3 start, vec3 mins, vec3 maxs, vec3 end, int type, edict_t *passedict) {
+    clip->start = start;
+    clip->end = end;
+    clip->mins = mins;
+    clip->maxs = maxs;
+    clip->type = type;
+    clip->passedict = passedict;
 
     if (type == MOVE_MISSILE) {
         for (int i = 0; i < 3; i++) {
-            clip.mins2[i] = -15;
-            clip.maxs2[i] = 15;
+            clip->mins2[i] = -15;
+            clip->maxs2[i] = 15;
         }
     } else {
-        clip.mins2 = mins;
-        clip.maxs2 = maxs;
+        clip->mins2 = mins;
+        clip->maxs2 = maxs;
     }
 
 // create the bounding box of the entire move
-    SV_MoveBounds(start, clip.mins2, clip.maxs2, end, clip.boxmins, clip.boxmaxs);
+    SV_MoveBounds(start, clip->mins2, clip->maxs2, end, clip->boxmins, clip->boxmaxs);
 
 // clip to entities
-    SV_ClipToLinks(sv_areanodes, &clip);
+    if (SV_GatherCovers(clip))
+        SV_ClipToList(&sv_gathered, clip);
+    else
+        SV_ClipToLinks(sv_areanodes.data(), clip);
+}
+
+/*
+==================
+SV_Move
+==================
+*/
+auto SV_Move(vec3 &start, vec3 mins, vec3 maxs, vec3 &end, int type, edict_t *passedict) -> trace_t {
+    moveclip_t clip{};
+
+// clip to world
+    clip.trace = SV_ClipMoveToEntity(sv.edicts, start, mins, maxs, end);
+
+    SV_ClipMoveToEntities(&clip, start, mins, maxs, end, type, passedict);
 
     return clip.trace;
 }
 
+/*
+==================
+SV_MoveBatch
+
+Traces count moves of the same box, with the same type and passedict,
+giving the traces SV_Move would. The world hull is walked for all of them
+at once, and the area tree once for the lot.
+==================
+*/
+void SV_MoveBatch(int count, const vec3 *starts, vec3 mins, vec3 maxs, const vec3 *ends, int type,
+                  edict_t *passedict, trace_t *traces) {
+    vec3 offset;
+    vec3 boxmins, boxmaxs;
+
+    if (count <= 0)
+        return;
+
+// clip to world
+    auto *hull = SV_HullForEntity(sv.edicts, mins, maxs, offset);
+    SV_HullCheckBatch(hull, count, starts, ends, offset, traces);
+
+// gather the entities around all of the moves
+    const auto missilemins = vec3(-15, -15, -15);
+    const auto missilemaxs = vec3(15, 15, 15);
+    for (int i = 0; i < count; i++) {
+        vec3 movemins, movemaxs;
+
+        if (type == MOVE_MISSILE)
+            SV_MoveBounds(starts[i], missilemins, missilemaxs, ends[i], movemins, movemaxs);
+        else
+            SV_MoveBounds(starts[i], mins, maxs, ends[i], movemins, movemaxs);
+
+        if (!i) {
+            boxmins = movemins;
+            boxmaxs = movemaxs;
+            continue;
+        }
+        for (int j = 0; j < 3; j++) {
+            if (movemins[j] < boxmins[j])
+                boxmins[j] = movemins[j];
+            if (movemaxs[j] > boxmaxs[j])
+                boxmaxs[j] = movemaxs[j];
+        }
+    }
+    SV_GatherMoves(boxmins, boxmaxs);
+
+// clip to entities
+    for (int i = 0; i < count; i++) {
+        moveclip_t clip{};
+
+        clip.trace = traces[i];
+        if (clip.trace.fraction < 1 || clip.trace.startsolid)
+            clip.trace.ent = sv.edicts;
+
+        SV_ClipMoveToEntities(&clip, starts[i], mins, maxs, ends[i], type, passedict);
+        traces[i] = clip.trace;
+    }
+
+    SV_ClearGather();
+}
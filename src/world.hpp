@@ -55,6 +55,22 @@ void SV_LinkEdict(edict_t *ent, qboolean touch_triggers);
 // sets ent->v.absmin and ent->v.absmax
 // if touchtriggers, calls prog functions for the intersected triggers
 
+auto SV_AreaContains(const edict_t *ent, const vec3 &point) -> bool;
+// true if point is inside the box ent was last linked with
+
+void SV_AreaEdicts(const vec3 &mins, const vec3 &maxs, std::vector<int> &nums);
+// adds the numbers of the linked edicts touching the box, in no particular order
+
+void SV_RetouchEdict(edict_t *ent);
+// calls the prog functions for the triggers ent is in, relinking it only if
+// it has moved since it was last linked
+
+void SV_ClearTouches(void);
+// forgets which triggers have touched what this frame
+
+void SV_ForgetTouches(edict_t *ent);
+// called when ent is freed, so whatever reuses the slot starts afresh
+
 int SV_PointContents(vec3 p);
 
 int SV_TruePointContents(vec3 p);
@@ -76,4 +92,21 @@ trace_t SV_Move(vec3 &start, vec3 mins, vec3 maxs, vec3 &end, int type, edict_t
 // shouldn't be considered solid objects
 
 // passedict is explicitly excluded from clipping checks (normally NULL)
-qboolean SV_RecursiveHullCheck(hull_t *hull, int num, float p1f, float p2f, vec3 p1, vec3 p2, trace_t *trace);
+
+void SV_MoveBatch(int count, const vec3 *starts, vec3 mins, vec3 maxs, const vec3 *ends, int type,
+                  edict_t *passedict, trace_t *traces);
+// the same as count SV_Moves, sharing the walk of the area tree
+
+void SV_GatherMoves(vec3 boxmins, vec3 boxmaxs);
+// SV_Moves inside the box check a list of the entities there instead of
+// walking the area tree, until something is linked or unlinked
+
+void SV_ClearGather(void);
+qboolean SV_HullCheck(hull_t *hull, int num, float p1f, float p2f, vec3 p1, vec3 p2, trace_t *trace);
+
+extern thread_local int *sv_tracebackups;
+// when set, traces count the times they had to back up past their start
+// here instead of printing it, for jobs that can't touch the console
+
+void SV_HullCheckBatch(hull_t *hull, int count, const vec3 *starts, const vec3 *ends, vec3 offset, trace_t *traces);
+// traces each start to its end through the hull placed at offset